@@ -0,0 +1,225 @@
+#include "Executor.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// the tasks [begin, end) left to a worker: it takes them from begin, thieves take them from end
+typedef struct executorDeque {
+    pthread_mutex_t lock;
+    int begin;
+    int end;
+} executorDeque;
+
+struct Executor_t {
+    int workers;
+    pthread_t* threads;      // workers - 1 threads, the thread calling ExecutorRun is the last worker
+    executorDeque* deques;   // one per worker
+    pthread_mutex_t lock;    // guards everything below
+    pthread_cond_t started;  // a run started, or the executor is being destroyed
+    pthread_cond_t finished; // a thread is done with the run
+    unsigned long run;       // runs started so far
+    int threadsDone;         // threads done with the current run
+    bool stopping;
+    ExecutorTask task;
+    void* context;
+};
+
+// a thread of the executor and the worker it is
+typedef struct executorThread {
+    Executor executor;
+    int worker;
+} executorThread;
+
+// takes the next task of the worker, stealing half of the tasks of another worker when it has none left
+// returns false once no worker has any task left
+bool takeTask(Executor executor, int worker, int* task_ptr){
+    executorDeque* own = &(executor->deques[worker]);
+    pthread_mutex_lock(&(own->lock));
+    if (own->begin < own->end){
+        *task_ptr = own->begin++;
+        pthread_mutex_unlock(&(own->lock));
+        return true;
+    }
+    pthread_mutex_unlock(&(own->lock));
+
+    executorDeque* victim;
+    int stolen, end;
+    for (int i = 1; i < executor->workers; i++){
+        victim = &(executor->deques[(worker + i) % executor->workers]);
+        pthread_mutex_lock(&(victim->lock));
+        stolen = (victim->end - victim->begin + 1) / 2;
+        end = victim->end;
+        victim->end -= stolen;
+        pthread_mutex_unlock(&(victim->lock));
+        if (stolen == 0)  continue;
+
+        // the first stolen task is run now, the rest become the worker's own
+        pthread_mutex_lock(&(own->lock));
+        own->begin = end - stolen + 1;
+        own->end = end;
+        pthread_mutex_unlock(&(own->lock));
+        *task_ptr = end - stolen;
+        return true;
+    }
+
+    return false;
+}
+
+void runWorker(Executor executor, int worker, ExecutorTask task, void* context){
+    int index;
+    while (takeTask(executor, worker, &index)){
+        task(context, index);
+    }
+}
+
+void* executorThreadMain(void* thread_ptr){
+    executorThread* thread = (executorThread*)thread_ptr;
+    Executor executor = thread->executor;
+    int worker = thread->worker;
+    free(thread);
+
+    unsigned long seen = 0;
+    ExecutorTask task; void* context;
+    while (true){
+        pthread_mutex_lock(&(executor->lock));
+        while (executor->run == seen && !(executor->stopping)){
+            pthread_cond_wait(&(executor->started), &(executor->lock));
+        }
+        if (executor->stopping){
+            pthread_mutex_unlock(&(executor->lock));
+            return NULL;
+        }
+        seen = executor->run;
+        task = executor->task;
+        context = executor->context;
+        pthread_mutex_unlock(&(executor->lock));
+
+        runWorker(executor, worker, task, context);
+
+        pthread_mutex_lock(&(executor->lock));
+        executor->threadsDone++;
+        pthread_cond_signal(&(executor->finished));
+        pthread_mutex_unlock(&(executor->lock));
+    }
+}
+
+// stops and joins the first count threads of the executor
+void stopThreads(Executor executor, int count){
+    pthread_mutex_lock(&(executor->lock));
+    executor->stopping = true;
+    pthread_cond_broadcast(&(executor->started));
+    pthread_mutex_unlock(&(executor->lock));
+    for (int i = 0; i < count; i++){
+        pthread_join(executor->threads[i], NULL);
+    }
+}
+
+void destroyExecutorState(Executor executor){
+    for (int i = 0; i < executor->workers; i++){
+        pthread_mutex_destroy(&(executor->deques[i].lock));
+    }
+    pthread_mutex_destroy(&(executor->lock));
+    pthread_cond_destroy(&(executor->started));
+    pthread_cond_destroy(&(executor->finished));
+    free(executor->deques);
+    free(executor->threads);
+    free(executor);
+}
+
+Executor ExecutorCreate(int workers){
+    if (workers < 0)  return NULL;
+    if (workers == EXECUTOR_DEFAULT_WORKERS){
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = processors > 0 ? (int)processors : 1;
+    }
+
+    Executor executor = (Executor)malloc(sizeof(struct Executor_t));
+    if (!executor)  return NULL;
+    executor->workers = workers;
+    executor->threads = (pthread_t*)malloc((workers > 1 ? workers - 1 : 1) * sizeof(pthread_t));
+    executor->deques = (executorDeque*)malloc(workers * sizeof(executorDeque));
+    if (!(executor->threads) || !(executor->deques)){
+        free(executor->threads);
+        free(executor->deques);
+        free(executor);
+        return NULL;
+    }
+    for (int i = 0; i < workers; i++){
+        pthread_mutex_init(&(executor->deques[i].lock), NULL);
+        executor->deques[i].begin = 0;
+        executor->deques[i].end = 0;
+    }
+    pthread_mutex_init(&(executor->lock), NULL);
+    pthread_cond_init(&(executor->started), NULL);
+    pthread_cond_init(&(executor->finished), NULL);
+    executor->run = 0;
+    executor->threadsDone = 0;
+    executor->stopping = false;
+    executor->task = NULL;
+    executor->context = NULL;
+
+    executorThread* thread;
+    for (int i = 0; i < workers - 1; i++){
+        thread = (executorThread*)malloc(sizeof(executorThread));
+        if (thread){
+            thread->executor = executor;
+            thread->worker = i;
+        }
+        if (!thread || pthread_create(&(executor->threads[i]), NULL, executorThreadMain, thread) != 0){
+            free(thread);
+            stopThreads(executor, i);
+            destroyExecutorState(executor);
+            return NULL;
+        }
+    }
+
+    return executor;
+}
+
+void ExecutorDestroy(Executor executor){
+    if (!executor)  return;
+
+    stopThreads(executor, executor->workers - 1);
+    destroyExecutorState(executor);
+}
+
+int ExecutorWorkers(Executor executor){
+    if (!executor)  return 0;
+
+    return executor->workers;
+}
+
+ExecutorError ExecutorRun(Executor executor, int count, ExecutorTask task, void* context){
+    if (!executor || count < 0 || !task)  return EXECUTOR_BAD_PARAM;
+
+    if (executor->workers == 1 || count == 1){ // in order, on this thread
+        for (int i = 0; i < count; i++){
+            task(context, i);
+        }
+        return EXECUTOR_SUCCESS;
+    }
+    if (count == 0)  return EXECUTOR_SUCCESS;
+
+    // no thread is running: every one of them was done with the previous run before it returned
+    int workers = executor->workers;
+    for (int i = 0; i < workers; i++){
+        executor->deques[i].begin = (int)((long long)count * i / workers);
+        executor->deques[i].end = (int)((long long)count * (i + 1) / workers);
+    }
+    pthread_mutex_lock(&(executor->lock));
+    executor->task = task;
+    executor->context = context;
+    executor->threadsDone = 0;
+    executor->run++;
+    pthread_cond_broadcast(&(executor->started));
+    pthread_mutex_unlock(&(executor->lock));
+
+    runWorker(executor, workers - 1, task, context);
+
+    pthread_mutex_lock(&(executor->lock));
+    while (executor->threadsDone < workers - 1){
+        pthread_cond_wait(&(executor->finished), &(executor->lock));
+    }
+    pthread_mutex_unlock(&(executor->lock));
+
+    return EXECUTOR_SUCCESS;
+}
@@ -0,0 +1,50 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#define EXECUTOR_DEFAULT_WORKERS 0 // one worker per online processor
+
+typedef struct Executor_t * Executor;
+
+typedef void (*ExecutorTask)(void*,int);
+
+typedef enum { EXECUTOR_SUCCESS, EXECUTOR_ALLOC_FAILED, EXECUTOR_BAD_PARAM, EXECUTOR_ERROR } ExecutorError;
+
+/**Error clarification:
+ * EXECUTOR_SUCCESS: Indicates the function has completed its task successfully with no errors.
+ * EXECUTOR_ALLOC_FAILED: Indicates memory allocation (or starting a thread) failed during the execution of the function.
+ * EXECUTOR_BAD_PARAM: Indicates an illegal parameter was passed.
+ * EXECUTOR_ERROR: Indicates any error beyond the above.
+ * */
+
+/**An Executor runs the independent tasks of ExecutorRun on a fixed set of workers: the thread calling
+ * ExecutorRun and workers - 1 threads started with the executor, which sleep between runs.
+ * The tasks of a run are split evenly between the workers, each worker runs its own tasks in order and,
+ * once it has none left, steals half of the tasks left to another worker.
+ * An executor with a single worker starts no thread and runs every task on the calling thread, in order,
+ * which makes a run deterministic for debugging.*/
+
+/**@param workers: how many workers run the tasks, EXECUTOR_DEFAULT_WORKERS for one per online processor
+ *
+ * Creates a new executor. Returns NULL if workers is negative or on failure.*/
+Executor ExecutorCreate(int workers);
+
+/**Stops the threads of the executor and deallocates it.*/
+void ExecutorDestroy(Executor);
+
+/**Returns the number of workers of the executor, 0 if the parameter is NULL.*/
+int ExecutorWorkers(Executor);
+
+/**@param count: the number of tasks
+ * @param task: called as task(context, i) for every i from 0 to count - 1
+ * @param context: passed to every task
+ *
+ * Runs the count tasks on the workers of the executor and returns once all of them are done. The tasks
+ * may run in any order and at the same time, except with a single worker, so they must not depend on
+ * each other. A run must not be started from a task, nor from two threads at once.*/
+ExecutorError ExecutorRun(Executor, int count, ExecutorTask task, void* context);
+
+#endif
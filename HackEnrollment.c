@@ -1,8 +1,32 @@
 #include "IsraeliQueue.h"
 #include "HackEnrollment.h"
+#include "Executor.h"
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 
 
 // STRUCTS
+#define ARENA_CHUNK_SIZE (1 << 20) // bytes allocated at once by an arena
+#define ARENA_ALIGNMENT 16         // every allocation starts at a multiple of it
+
+// a block of memory handed out from its start
+typedef struct ArenaChunk{
+    struct ArenaChunk* next;
+    size_t size;
+    size_t used;
+    char memory[];
+} ArenaChunk;
+
+// hands out memory that is only freed all at once, when the arena is destroyed
+typedef struct Arena{
+    ArenaChunk* chunks; // newest chunk first
+} Arena;
+
 typedef struct Node
 {
     void *element_ptr;
@@ -12,31 +36,48 @@ typedef struct Node
 typedef struct Queue_t{
     Node *head;
     Node *last;
+    Arena *arena; // where the nodes come from
 } Queue_t;
 
 typedef struct Queue_t *Queue;
 
+// a sorted set of student IDs without repeats, searched by binary search
+typedef struct IDSet{
+    long* ids;
+    int size;
+} IDSet;
+
+struct Course;
+
 typedef struct Hacker{
     /*  <Student ID> \n
         <Course Numbers>*\n //Desired courses
         <Student ID>*\n //Friends
         <Student ID>*\n //Rivals
     */
-    Queue desiredCoursesNums;
-    Queue friendsIDs;
-    Queue rivalsIDs;
+    struct Course** desiredCourses; // in the order of the file, found when it is read, NULL for an unknown course number
+    int desiredCount;
+    IDSet friendsIDs;
+    IDSet rivalsIDs;
 } Hacker;
 
+// a string that isn't NUL terminated: a copy owned by its student, or a part of a mapped file
+typedef struct StringView{
+    const char* chars;
+    size_t length;
+} StringView;
+
 typedef struct Student
 {
     // <Student ID> <Total Credits> <GPA> <Name> <Surname> <City> <Department>\n
     long studentID;
     int totalCredits;
     int gpa;
-    char *name;
-    char *surname;
-    char *city;
-    char *department;
+    StringView name;
+    long nameAscii; // sum of the characters of name, computed once when it is read
+    StringView surname;
+    StringView city;       // interned in the system's string pool, equal cities have the same chars pointer
+    StringView department; // interned in the system's string pool, like city
     Hacker *hackerAlt;
 } Student;
 
@@ -45,26 +86,152 @@ typedef struct Course{
     long courseNum;
     int size;
     IsraeliQueue courseQueue;
+    Student** enrolled; // the first size students of the queue by address, only while findDissatisfied runs
+    int enrolledCount;
 } Course;
 
+// a record (student or course) and the number it is looked up by, an empty slot has a NULL record
+typedef struct RecordEntry{
+    long key;
+    void* record;
+} RecordEntry;
+
+// open addressing with linear probing, from student ID or course number to the record
+typedef struct RecordMap{
+    RecordEntry* entries;
+    size_t mask; // number of slots - 1
+} RecordMap;
+
+// a copy of every distinct string, stored once and shared by all the students using it
+typedef struct PooledString{
+    StringView view;    // NULL chars for an empty slot
+    unsigned long hash;
+} PooledString;
+
+// open addressing with linear probing
+typedef struct StringPool{
+    Arena* arena;        // where the strings are kept
+    PooledString* entries;
+    size_t mask; // number of slots - 1
+    size_t used; // full slots
+} StringPool;
+
+// a whole file mapped into memory, NULL data for an empty file
+typedef struct MappedFile{
+    char* data;
+    size_t size;
+} MappedFile;
+
 typedef struct EnrollmentSystem_t
 {
+    // every student, hacker, course and queue node of the system, and their strings
+    Arena arena;
     // students nodes (pointer to hackers)
     Queue studentsQueue;
     // courses nodes + queuesB
     Queue coursesQueue;
+    // the students of the hackers, in the order of the hackers file
+    Queue hackersQueue;
     // queues nodes (pointer to every Israeli Queue)
+    // lookup by student ID and by course number, built once the queues are read
+    RecordMap studentsByID;
+    RecordMap coursesByNum;
+    // the students file when it was mapped, the students' strings point into it
+    MappedFile studentsText;
+    // the distinct cities and departments of the students
+    StringPool strings;
+    // runs the work of independent courses concurrently, created on first use with the given number of workers
+    Executor executor;
+    int workers;
 } EnrollmentSystem_t;
 
-typedef struct EnrollmentSystem_t* EnrollmentSystem;
-
 
 typedef enum { STUDENTS_Q, COURSES_Q, DEFAULT_Q } QueueType;
 
+#define READER_CHUNK_SIZE (1 << 16) // bytes read from a file at once
+
+// reads a file in big chunks, numbers and words are scanned in place in the buffer
+// a reader of a mapped file has the whole file as its buffer and no FILE
+typedef struct Reader{
+    FILE* file;
+    char* buffer;
+    size_t capacity;
+    size_t pos;  // next unread character
+    size_t len;  // characters in the buffer
+    bool ended;  // a read went past the end of the file, like feof
+    bool failed; // the buffer couldn't grow for a long token, so the reader ended before the end of the file
+} Reader;
+
+
+// ARENA
+// returns size bytes from the arena, NULL on allocation failure
+void* arenaAlloc(Arena* arena, size_t size){
+    if (!arena)  return NULL; // bad parameter
+
+    ArenaChunk* chunk = arena->chunks;
+    size_t start = 0;
+    if (chunk){ // align the start of the memory itself, not its offset
+        start = chunk->used + ((ARENA_ALIGNMENT - (uintptr_t)(chunk->memory + chunk->used) % ARENA_ALIGNMENT) % ARENA_ALIGNMENT);
+    }
+    if (!chunk || start + size > chunk->size){ // a new chunk, bigger than usual for a big allocation
+        size_t chunkSize = size + ARENA_ALIGNMENT > ARENA_CHUNK_SIZE ? size + ARENA_ALIGNMENT : ARENA_CHUNK_SIZE;
+        chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + chunkSize);
+        if (!chunk)  return NULL;
+        chunk->next = arena->chunks;
+        chunk->size = chunkSize;
+        chunk->used = 0;
+        arena->chunks = chunk;
+        start = (ARENA_ALIGNMENT - (uintptr_t)(chunk->memory) % ARENA_ALIGNMENT) % ARENA_ALIGNMENT;
+    }
+
+    chunk->used = start + size;
+    return chunk->memory + start;
+}
+
+// moves every chunk of src to dest, which keeps handing out memory from its current chunk
+void adoptArena(Arena* dest, Arena* src){
+    if (!dest || !src || !(src->chunks)) return; // nothing to move
+
+    ArenaChunk* last = src->chunks;
+    while (last->next){
+        last = last->next;
+    }
+    if (dest->chunks){
+        last->next = dest->chunks->next;
+        dest->chunks->next = src->chunks;
+    }
+    else{
+        dest->chunks = src->chunks;
+    }
+    src->chunks = NULL;
+}
+
+// frees all the memory handed out by the arena at once
+void destroyArena(Arena* arena){
+    if (!arena) return; // bad parameter
+    ArenaChunk* tmp;
+    while (arena->chunks){
+        tmp = arena->chunks;
+        arena->chunks = tmp->next;
+        free(tmp);
+    }
+}
+
 
 // QUEUE
-Node* createNode(void* item){
-    Node* node_ptr = (Node*)malloc(sizeof(Node));
+Queue createQueue(Arena* arena){
+    Queue q = (Queue)arenaAlloc(arena, sizeof(Queue_t));
+    if (q == NULL)  return NULL;
+
+    q->head = NULL;
+    q->last = NULL;
+    q->arena = arena;
+
+    return q;
+}
+
+Node* createNode(Arena* arena, void* item){
+    Node* node_ptr = (Node*)arenaAlloc(arena, sizeof(Node));
     if (node_ptr == NULL){
         return NULL;
     }
@@ -78,7 +245,7 @@ Node* createNode(void* item){
 HackEnrollmentError enqueue(Queue q, void* item){
     if (!q || !item)   return HACKENROLLMENT_BAD_PARAM;
 
-    Node* node = createNode(item);
+    Node* node = createNode(q->arena, item);
     if (node == NULL){
         return HACKENROLLMENT_ALLOC_FAILED;
     }
@@ -94,45 +261,218 @@ HackEnrollmentError enqueue(Queue q, void* item){
     return HACKENROLLMENT_SUCCESS;
 }
 
-void destroyStudent(Student* student);
-void destroyHacker(Hacker* hacker);
+long findStringAscii(StringView s);
 void destroyCourse(Course* course);
-void dequeueQueue(Queue q, QueueType typeQ);
 void destroyQueue(Queue q, QueueType typeQ);
 
-void dequeueQueue(Queue q, QueueType typeQ){
-    if (q == NULL || (q->head) == NULL)  return;
+// the nodes belong to the arena, only the elements holding something else are destroyed
+void destroyQueue(Queue q, QueueType typeQ){
+    if (!q || typeQ != COURSES_Q) return; // nothing outside the arena
 
-    Node* tmp = q->head; // save HEAD for dequeue
-    q->head = tmp->next; // remove HEAD from queue
+    for (Node* cur = q->head; cur != NULL; cur = cur->next){
+        destroyCourse((Course*)(cur->element_ptr));
+    }
+    q->head = NULL;
+    q->last = NULL;
+}
+// STRING POOL
+unsigned long hashString(StringView s){ // FNV-1a
+    unsigned long hash = 14695981039346656037ul;
+    for (size_t i = 0; i < s.length; i++){
+        hash ^= (unsigned char)(s.chars[i]);
+        hash *= 1099511628211ul;
+    }
+    return hash;
+}
 
-    // free element_ptr
-    if (typeQ == STUDENTS_Q){
-        destroyStudent((Student*)(tmp->element_ptr));
+// doubles the number of slots (or allocates the first ones) and places every string again
+HackEnrollmentError growStringPool(StringPool* pool){
+    size_t slots = pool->entries ? 2 * (pool->mask + 1) : 64;
+    PooledString* entries = (PooledString*)calloc(slots, sizeof(PooledString));
+    if (!entries)  return HACKENROLLMENT_ALLOC_FAILED;
+
+    size_t slot;
+    for (size_t i = 0; pool->entries && i <= pool->mask; i++){
+        if (!(pool->entries[i].view.chars))  continue;
+        slot = pool->entries[i].hash & (slots - 1);
+        while (entries[slot].view.chars){
+            slot = (slot + 1) & (slots - 1);
+        }
+        entries[slot] = pool->entries[i];
     }
-    else if (typeQ == COURSES_Q){
-        destroyCourse((Course*)(tmp->element_ptr));
+    free(pool->entries);
+    pool->entries = entries;
+    pool->mask = slots - 1;
+
+    return HACKENROLLMENT_SUCCESS;
+}
+
+// sets *interned to the pool's copy of s, adding one if it is the first time s is seen
+HackEnrollmentError internString(StringPool* pool, StringView s, StringView* interned){
+    if (!pool || !interned)  return HACKENROLLMENT_BAD_PARAM;
+    if (!(pool->entries) || (pool->used + 1) * 2 > pool->mask + 1){ // keep at most half of the slots full
+        if (growStringPool(pool) != HACKENROLLMENT_SUCCESS)  return HACKENROLLMENT_ALLOC_FAILED;
     }
 
-    free(tmp); // free HEAD
-    return;
+    unsigned long hash = hashString(s);
+    size_t slot = hash & pool->mask;
+    PooledString* entry;
+    while ((entry = &(pool->entries[slot]))->view.chars){
+        if (entry->hash == hash && entry->view.length == s.length && memcmp(entry->view.chars, s.chars, s.length) == 0){
+            *interned = entry->view;
+            return HACKENROLLMENT_SUCCESS;
+        }
+        slot = (slot + 1) & pool->mask;
+    }
+
+    char* chars = (char*)arenaAlloc(pool->arena, s.length * sizeof(char) + 1);
+    if (!chars)  return HACKENROLLMENT_ALLOC_FAILED;
+    memcpy(chars, s.chars, s.length);
+    chars[s.length] = '\0';
+    entry->view.chars = chars;
+    entry->view.length = s.length;
+    entry->hash = hash;
+    pool->used++;
+
+    *interned = entry->view;
+    return HACKENROLLMENT_SUCCESS;
 }
 
-void destroyQueue(Queue q, QueueType typeQ){
-    if (!q) return; // already freed
+void destroyStringPool(StringPool* pool){
+    if (!pool || !(pool->entries)) return; // already freed
+    free(pool->entries); // the strings themselves belong to the arena
+    pool->entries = NULL;
+}
+
+// READER
+Reader* createReader(FILE* file){
+    if (!file)  return NULL; // bad parameter
+
+    Reader* reader = (Reader*)malloc(sizeof(Reader));
+    if (!reader)  return NULL;
+    reader->buffer = (char*)malloc(READER_CHUNK_SIZE);
+    if (!(reader->buffer)){
+        free(reader);
+        return NULL;
+    }
+    reader->file = file;
+    reader->capacity = READER_CHUNK_SIZE;
+    reader->pos = 0;
+    reader->len = 0;
+    reader->ended = false;
+    reader->failed = false;
+
+    return reader;
+}
+
+// a reader over the mapped file, which parses it in place without reading or copying anything
+Reader* createMappedReader(MappedFile* mapped){
+    if (!mapped)  return NULL; // bad parameter
+
+    Reader* reader = (Reader*)malloc(sizeof(Reader));
+    if (!reader)  return NULL;
+    reader->file = NULL;
+    reader->buffer = mapped->data;
+    reader->capacity = mapped->size;
+    reader->pos = 0;
+    reader->len = mapped->size;
+    reader->ended = false;
+    reader->failed = false;
+
+    return reader;
+}
+
+void destroyReader(Reader* reader){
+    if (!reader) return; // already freed
+    if (reader->file)  free(reader->buffer); // a mapped buffer belongs to its MappedFile
+    free(reader);
+}
+
+// maps the whole file at path for reading
+HackEnrollmentError mapFile(const char* path, MappedFile* mapped){
+    if (!path || !mapped)  return HACKENROLLMENT_BAD_PARAM;
+    mapped->data = NULL;
+    mapped->size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)  return HACKENROLLMENT_ERROR;
+    struct stat info;
+    if (fstat(fd, &info) == -1){
+        close(fd);
+        return HACKENROLLMENT_ERROR;
+    }
+    if (info.st_size == 0){ // nothing to map
+        close(fd);
+        return HACKENROLLMENT_SUCCESS;
+    }
+
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if (data == MAP_FAILED)  return HACKENROLLMENT_ERROR;
+    mapped->data = (char*)data;
+    mapped->size = (size_t)info.st_size;
+
+    return HACKENROLLMENT_SUCCESS;
+}
+
+void unmapFile(MappedFile* mapped){
+    if (!mapped || !(mapped->data)) return; // already unmapped
+    munmap(mapped->data, mapped->size);
+    mapped->data = NULL;
+    mapped->size = 0;
+}
+
+// reads the next chunk of the file, keeping the characters from *keep_ptr on (the token being scanned),
+// which are moved to the front of the buffer. The buffer only grows for a token longer than all of it.
+// returns false at the end of the file, or when the buffer couldn't grow, which also sets failed: the loops
+// reading until ended stop the same way, and their callers report the failure instead of a shorter file
+bool fillReader(Reader* reader, size_t* keep_ptr){
+    if (!(reader->file)){ // a mapped file is all in the buffer already
+        reader->ended = true;
+        return false;
+    }
+    size_t keep = *keep_ptr;
+    if (keep > 0){
+        memmove(reader->buffer, reader->buffer + keep, reader->len - keep);
+        reader->len -= keep;
+        reader->pos -= keep;
+        *keep_ptr = 0;
+    }
+    if (reader->len == reader->capacity){
+        char* buffer = (char*)realloc(reader->buffer, 2 * reader->capacity);
+        if (!buffer){
+            reader->ended = true;
+            reader->failed = true;
+            return false;
+        }
+        reader->buffer = buffer;
+        reader->capacity *= 2;
+    }
 
-    while (q->head != NULL){
-        dequeueQueue(q, typeQ);
+    size_t n = fread(reader->buffer + reader->len, 1, reader->capacity - reader->len, reader->file);
+    if (n == 0){
+        reader->ended = true;
+        return false;
     }
-    free(q);
+    reader->len += n;
+    return true;
 }
 
-long readStringIntoLong(FILE *file, bool* endofline_ptr){
-    if (!file || !endofline_ptr)  return -1; // bad parameters
+// returns the next character of the file, EOF at its end
+int nextChar(Reader* reader){
+    if (reader->pos == reader->len){
+        size_t keep = reader->pos;
+        if (!fillReader(reader, &keep))  return EOF;
+    }
+    return (unsigned char)(reader->buffer[reader->pos++]);
+}
+
+long readStringIntoLong(Reader* reader, bool* endofline_ptr){
+    if (!reader || !endofline_ptr)  return -1; // bad parameters
 
-    char digit = '0';
-    while (!('0' <= (digit = fgetc(file)) && digit <= '9')){ // skip till first digit
-        if (feof(file)){
+    int digit;
+    while (!('0' <= (digit = nextChar(reader)) && digit <= '9')){ // skip till first digit
+        if (digit == EOF){
             *endofline_ptr = true;
             return -1;
         }
@@ -141,7 +481,7 @@ long readStringIntoLong(FILE *file, bool* endofline_ptr){
     while ('0' <= digit && digit <= '9'){
         num *= 10;
         num += digit - '0';
-        digit = fgetc(file);
+        digit = nextChar(reader);
 
         if (digit == '\r' || digit == '\n'){
             *endofline_ptr = true;
@@ -151,97 +491,121 @@ long readStringIntoLong(FILE *file, bool* endofline_ptr){
     return num;
 }
 
-char* readWord(FILE* file, bool* endofline_ptr){
-    if (!file || !endofline_ptr)  return NULL; // bad parameters
+// finds the next word, which stays in the reader's buffer: it is only valid until the next read
+// returns false if there is no word left
+bool scanWord(Reader* reader, bool* endofline_ptr, StringView* word){
+    if (!reader || !endofline_ptr || !word)  return false; // bad parameters
 
-    char* word = (char*)malloc(sizeof(char));
-    if (!word)  return NULL;
-    int wordSize = 1;
-    char c;
-    while (!(('a' <= (c = fgetc(file)) && c <= 'z') || ('A' <= c && c <= 'Z'))){ // skip till first letter or end of file
-        if (feof(file)){
+    int c;
+    while (!(('a' <= (c = nextChar(reader)) && c <= 'z') || ('A' <= c && c <= 'Z'))){ // skip till first letter or end of file
+        if (c == EOF){
             *endofline_ptr = true;
-            return NULL;
+            return false;
         }
     }
-    while (c != ' ') {
-        word = realloc(word, (++wordSize) * sizeof(char));
-        word[wordSize - 2] = c;
-        c=fgetc(file);
-
-        if (c == '\r' || c == '\n'){ // indecator to end of line
-            *endofline_ptr = true;
-            break;
+    // scan the word in place, it ends at a space, at the end of the line or at the end of the file
+    size_t start = reader->pos - 1;
+    char* buffer;
+    while (true){
+        buffer = reader->buffer;
+        while (reader->pos < reader->len && buffer[reader->pos] != ' ' && buffer[reader->pos] != '\r' && buffer[reader->pos] != '\n'){
+            reader->pos++;
         }
+        if (reader->pos < reader->len || !fillReader(reader, &start))  break;
     }
+    word->chars = reader->buffer + start;
+    word->length = reader->pos - start;
 
-    word[wordSize - 1] = '\0';
-    return word;
+    // the character that ended the word, a chunk is never read while it is still on the buffer
+    if (reader->pos == reader->len){
+        *endofline_ptr = true; // end of file
+        return true;
+    }
+    c = reader->buffer[reader->pos++];
+    if (c == '\r' || c == '\n'){ // indecator to end of line
+        *endofline_ptr = true;
+    }
+    return true;
+}
+
+// reads the next word into word, copied into the arena unless the reader is over a mapped file
+// returns false if there is no word left or on allocation failure
+bool readWord(Reader* reader, Arena* arena, bool* endofline_ptr, StringView* word){
+    if (!scanWord(reader, endofline_ptr, word))  return false;
+
+    if (reader->file){ // the buffer is reused, keep a copy
+        char* chars = (char*)arenaAlloc(arena, word->length * sizeof(char) + 1);
+        if (!chars)  return false;
+        memcpy(chars, word->chars, word->length);
+        chars[word->length] = '\0';
+        word->chars = chars;
+    }
+    return true;
+}
+
+// reads the next word into word as the pool's copy of it
+// returns false if there is no word left or on allocation failure
+bool readPooledWord(Reader* reader, StringPool* pool, bool* endofline_ptr, StringView* word){
+    StringView scanned;
+    if (!scanWord(reader, endofline_ptr, &scanned))  return false;
+    return internString(pool, scanned, word) == HACKENROLLMENT_SUCCESS;
 }
 
 // STUDENTS
-Student* createStudent(FILE* students){
-    if (!students)  return NULL; // bad parameter
+// without a pool, the city and department are read like the other words, to be interned later
+Student* createStudent(Reader* students, Arena* arena, StringPool* strings){
+    if (!students || !arena)  return NULL; // bad parameters
     
     // <Student ID> <Total Credits> <GPA> <Name> <Surname> <City> <Department>\n
     bool eol = false;
-    Student* student_ptr = (Student*)malloc(sizeof(Student));
+    Student* student_ptr = (Student*)arenaAlloc(arena, sizeof(Student));
+    if (student_ptr == NULL)  return NULL;
+    StringView empty = { NULL, 0 };
+    student_ptr->name = empty;
+    student_ptr->surname = empty;
+    student_ptr->city = empty;
+    student_ptr->department = empty;
+    student_ptr->hackerAlt = NULL;
     student_ptr->studentID = readStringIntoLong(students, &eol);
-    if (eol){ destroyStudent(student_ptr); return NULL; } // line ended prematurely
+    if (eol)  return NULL; // line ended prematurely, the arena takes the student back with everything else
     eol = false;
 
     student_ptr->totalCredits = (int)readStringIntoLong(students, &eol);
-    if (eol){ destroyStudent(student_ptr); return NULL; } // line ended prematurely
+    if (eol)  return NULL; // line ended prematurely, the arena takes the student back with everything else
     eol = false;
 
     student_ptr->gpa = (int)readStringIntoLong(students, &eol);
-    if (eol){ destroyStudent(student_ptr); return NULL; } // line ended prematurely
+    if (eol)  return NULL; // line ended prematurely, the arena takes the student back with everything else
     eol = false;
 
-    student_ptr->name = readWord(students, &eol);
-    if (eol){ destroyStudent(student_ptr); return NULL; } // line ended prematurely
+    if (!readWord(students, arena, &eol, &(student_ptr->name)) || eol)  return NULL; // no word, allocation failure or line ended prematurely, the arena takes the student back with everything else
     eol = false;
+    student_ptr->nameAscii = findStringAscii(student_ptr->name);
 
-    student_ptr->surname = readWord(students, &eol);
-    if (eol){ destroyStudent(student_ptr); return NULL; } // line ended prematurely
+    if (!readWord(students, arena, &eol, &(student_ptr->surname)) || eol)  return NULL; // same as for the name
     eol = false;
 
-    student_ptr->city = readWord(students, &eol);
-    if (eol){ destroyStudent(student_ptr); return NULL; } // line ended prematurely
+    if ((strings ? !readPooledWord(students, strings, &eol, &(student_ptr->city))
+                 : !readWord(students, arena, &eol, &(student_ptr->city))) || eol)  return NULL; // same as for the name
     eol = false;
 
-    student_ptr->department = readWord(students, &eol);
-    if (!(student_ptr->department)){ destroyStudent(student_ptr); return NULL; } // line ended prematurely
+    if (strings ? !readPooledWord(students, strings, &eol, &(student_ptr->department))
+                : !readWord(students, arena, &eol, &(student_ptr->department)))  return NULL; // line ended prematurely, the arena takes the student back with everything else
     student_ptr->hackerAlt = NULL;
 
     return student_ptr;
 }
 
-void destroyStudent(Student* student){
-    if (!student) return; // already freed
-    if (!(student->name))         free(student->name);;
-    if (!(student->surname))      free(student->surname);
-    if (!(student->city))         free(student->city);
-    if (!(student->department))   free(student->department);
-    destroyHacker(student->hackerAlt);
-    free(student);
-    return;
-}
-
-Queue createStudentsQueue(FILE *students){
+Queue createStudentsQueue(Reader* students, Arena* arena, StringPool* strings){
     if (!students)  return NULL; // bad parameter
-    Queue q = (Queue)malloc(sizeof(Queue_t));
+    Queue q = createQueue(arena);
     if (q == NULL)  return NULL;
 
-    q->head = NULL;
-    q->last = NULL;
-
     Student* cur_student;
-    while(!feof(students)){
-        cur_student = createStudent(students);
+    while(!(students->ended)){
+        cur_student = createStudent(students, arena, strings);
         if (!cur_student) break;
         if (enqueue(q, cur_student) == HACKENROLLMENT_ALLOC_FAILED){
-            destroyQueue(q, STUDENTS_Q);
             return NULL;
         }
     }
@@ -249,175 +613,217 @@ Queue createStudentsQueue(FILE *students){
     return q;
 }
 
-Student* findStudent(Queue students, Node* startingPos, long studentID){
-    if (!students || !startingPos)  return NULL; // bad parameter
 
-    Node* curNode = startingPos;
-    Student* curStudent;
-    while (curNode != NULL){
-        curStudent = curNode->element_ptr;
-        if (curStudent == NULL)  return NULL; // error
-        if (curStudent->studentID == studentID){
-            return curStudent;
-        }
-        curNode = curNode->next;
-    }
 
-    return NULL;
+// RECORD MAPS
+size_t recordSlot(RecordMap* map, long key){
+    unsigned long hash = (unsigned long)key; // IDs are far from uniform, mix them first
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDul;
+    hash ^= hash >> 33;
+    return (size_t)hash & map->mask;
 }
 
+// maps the key of every record in q, keeping the first record of a repeated key like a walk over q would
+HackEnrollmentError buildRecordMap(RecordMap* map, Queue q, QueueType typeQ){
+    if (!map || !q)  return HACKENROLLMENT_BAD_PARAM;
 
-// HACKERS
-Queue createHackerCoursesQueue(FILE* hackers){
-    if (!hackers)  return NULL; // bad parameter
+    size_t count = 0;
+    for (Node* cur = q->head; cur != NULL; cur = cur->next){
+        count++;
+    }
+    size_t slots = 8;
+    while (slots < 2 * count){ // at most half full
+        slots *= 2;
+    }
+    map->entries = (RecordEntry*)calloc(slots, sizeof(RecordEntry));
+    if (!(map->entries))  return HACKENROLLMENT_ALLOC_FAILED;
+    map->mask = slots - 1;
+
+    long key; size_t slot;
+    for (Node* cur = q->head; cur != NULL; cur = cur->next){
+        if (!(cur->element_ptr))  return HACKENROLLMENT_ERROR;
+        key = typeQ == STUDENTS_Q ? ((Student*)(cur->element_ptr))->studentID : ((Course*)(cur->element_ptr))->courseNum;
+        slot = recordSlot(map, key);
+        while (map->entries[slot].record != NULL && map->entries[slot].key != key){
+            slot = (slot + 1) & map->mask;
+        }
+        if (map->entries[slot].record == NULL){
+            map->entries[slot].key = key;
+            map->entries[slot].record = cur->element_ptr;
+        }
+    }
 
-    Queue desiredQueuesNums = (Queue)malloc(sizeof(Queue_t));
-    if (desiredQueuesNums == NULL)  return NULL;
+    return HACKENROLLMENT_SUCCESS;
+}
 
-    desiredQueuesNums->head = NULL;
-    desiredQueuesNums->last = NULL;
+// returns the record of key, NULL if there is none
+void* findRecord(RecordMap* map, long key){
+    if (!map || !(map->entries))  return NULL;
 
-    long* courseNum_ptr;
-    bool endofline = false;
-    while (!feof(hackers)){
-        courseNum_ptr = (long*)malloc(sizeof(long));
-        if (!courseNum_ptr){
-            destroyQueue(desiredQueuesNums, DEFAULT_Q);
-            return NULL;
+    size_t slot = recordSlot(map, key);
+    while (map->entries[slot].record != NULL){
+        if (map->entries[slot].key == key){
+            return map->entries[slot].record;
         }
-        *courseNum_ptr = readStringIntoLong(hackers, &endofline);
-        if ((*courseNum_ptr) == -1)  break;
-        if (enqueue(desiredQueuesNums, courseNum_ptr) == HACKENROLLMENT_ALLOC_FAILED){
-            destroyQueue(desiredQueuesNums, COURSES_Q);
-            return NULL;
-        }
-        if (endofline)  break;
+        slot = (slot + 1) & map->mask;
     }
+    return NULL;
+}
 
-    return desiredQueuesNums;
+Student* findStudent(EnrollmentSystem sys, long studentID){
+    if (!sys)  return NULL; // bad parameter
+    return (Student*)findRecord(&(sys->studentsByID), studentID);
 }
 
-Queue createHackerFriends(FILE* hackers){
-    Queue friendsIDs = (Queue)malloc(sizeof(Queue_t));
-    if (friendsIDs == NULL){
-        return NULL;
-    }
+Course* findCourse(EnrollmentSystem sys, long courseNum){
+    if (!sys)  return NULL; // bad parameter
+    return (Course*)findRecord(&(sys->coursesByNum), courseNum);
+}
 
-    friendsIDs->head = NULL;
-    friendsIDs->last = NULL;
 
-    long* friendID_ptr;
+// HACKERS
+// reads a line of course numbers into the hacker's desired courses, found once here instead of on every use
+// the numbers are gathered in scratch, reused from line to line, and only the courses are kept in the arena
+HackEnrollmentError readDesiredCourses(EnrollmentSystem sys, Reader* hackers, IDSet* scratch, int* scratchCapacity_ptr, Hacker* hacker){
+    if (!sys || !hackers || !scratch || !scratchCapacity_ptr || !hacker)  return HACKENROLLMENT_BAD_PARAM;
+
+    scratch->size = 0;
+    long courseNum; long* tmp;
     bool endofline = false;
-    while (!feof(hackers)){
-        friendID_ptr = (long*)malloc(sizeof(long));
-        if (!friendID_ptr){
-            destroyQueue(friendsIDs, DEFAULT_Q);
-            return NULL;
-        }
-        *friendID_ptr = readStringIntoLong(hackers, &endofline);
-        if ((*friendID_ptr) == -1)  break;
-        if (enqueue(friendsIDs, friendID_ptr) == HACKENROLLMENT_ALLOC_FAILED){
-            destroyQueue(friendsIDs, DEFAULT_Q);
-            return NULL;
+    while (!(hackers->ended)){
+        courseNum = readStringIntoLong(hackers, &endofline);
+        if (courseNum == -1)  break;
+        if (scratch->size == *scratchCapacity_ptr){
+            tmp = (long*)realloc(scratch->ids, 2 * (*scratchCapacity_ptr) * sizeof(long));
+            if (!tmp)  return HACKENROLLMENT_ALLOC_FAILED;
+            scratch->ids = tmp;
+            *scratchCapacity_ptr *= 2;
         }
+        scratch->ids[scratch->size++] = courseNum;
         if (endofline)  break;
     }
 
-    return friendsIDs;
+    hacker->desiredCount = scratch->size;
+    hacker->desiredCourses = NULL;
+    if (scratch->size == 0)  return HACKENROLLMENT_SUCCESS;
+    hacker->desiredCourses = (Course**)arenaAlloc(&(sys->arena), scratch->size * sizeof(Course*));
+    if (!(hacker->desiredCourses))  return HACKENROLLMENT_ALLOC_FAILED;
+    for (int i = 0; i < scratch->size; i++){
+        hacker->desiredCourses[i] = findCourse(sys, scratch->ids[i]);
+    }
+
+    return HACKENROLLMENT_SUCCESS;
 }
 
-Queue createHackerRivals(FILE* hackers){
-    Queue rivalsIDs = (Queue)malloc(sizeof(Queue_t));
-    if (rivalsIDs == NULL){
-        return NULL;
-    }
+int compareIDs(const void* id1, const void* id2){
+    long a = *(const long*)id1, b = *(const long*)id2;
+    return (a > b) - (a < b);
+}
 
-    rivalsIDs->head = NULL;
-    rivalsIDs->last = NULL;
+// reads a line of student IDs (friends or rivals) into set, sorted and without repeats
+// the line is gathered in scratch, reused from line to line, and only the final set is kept in the arena
+HackEnrollmentError readIDSet(Reader* hackers, Arena* arena, IDSet* scratch, int* scratchCapacity_ptr, IDSet* set){
+    if (!hackers || !scratch || !scratchCapacity_ptr || !set)  return HACKENROLLMENT_BAD_PARAM;
 
-    long* rivalID_ptr;
+    set->ids = NULL;
+    set->size = 0;
+    scratch->size = 0;
+    long id; long* tmp;
     bool endofline = false;
-    while (!feof(hackers)){
-        rivalID_ptr = (long*)malloc(sizeof(long));
-        if (!rivalID_ptr){
-            destroyQueue(rivalsIDs, DEFAULT_Q);
-            return NULL;
-        }
-        *rivalID_ptr = readStringIntoLong(hackers, &endofline);
-        if ((*rivalID_ptr) == -1)  break;
-        if (enqueue(rivalsIDs, rivalID_ptr) == HACKENROLLMENT_ALLOC_FAILED){
-            destroyQueue(rivalsIDs, DEFAULT_Q);
-            return NULL;
+    while (!(hackers->ended)){
+        id = readStringIntoLong(hackers, &endofline);
+        if (id == -1)  break;
+        if (scratch->size == *scratchCapacity_ptr){
+            tmp = (long*)realloc(scratch->ids, 2 * (*scratchCapacity_ptr) * sizeof(long));
+            if (!tmp)  return HACKENROLLMENT_ALLOC_FAILED;
+            scratch->ids = tmp;
+            *scratchCapacity_ptr *= 2;
         }
+        scratch->ids[scratch->size++] = id;
         if (endofline)  break;
     }
 
-    return rivalsIDs;
+    if (scratch->size == 0)  return HACKENROLLMENT_SUCCESS;
+    qsort(scratch->ids, scratch->size, sizeof(long), compareIDs);
+    int unique = 1;
+    for (int i = 1; i < scratch->size; i++){
+        if (scratch->ids[i] != scratch->ids[unique - 1]){
+            scratch->ids[unique++] = scratch->ids[i];
+        }
+    }
+
+    set->ids = (long*)arenaAlloc(arena, unique * sizeof(long));
+    if (!(set->ids))  return HACKENROLLMENT_ALLOC_FAILED;
+    memcpy(set->ids, scratch->ids, unique * sizeof(long));
+    set->size = unique;
+
+    return HACKENROLLMENT_SUCCESS;
 }
 
-HackEnrollmentError fillHackerInfo(Student* hacker, FILE* hackers){
-    if (!hacker || !hackers) return HACKENROLLMENT_BAD_PARAM;
+HackEnrollmentError fillHackerInfo(EnrollmentSystem sys, Student* hacker, Reader* hackers, IDSet* scratch, int* scratchCapacity_ptr){
+    if (!sys || !hacker || !hackers) return HACKENROLLMENT_BAD_PARAM;
 
-    hacker->hackerAlt = (Hacker*)malloc(sizeof(Hacker));
-    if (hacker->hackerAlt == NULL){
-        return HACKENROLLMENT_ALLOC_FAILED;
-    }
-    hacker->hackerAlt->desiredCoursesNums = createHackerCoursesQueue(hackers);
-    if (hacker->hackerAlt->desiredCoursesNums == NULL){
-        free(hacker->hackerAlt);
+    Arena* arena = &(sys->arena);
+    Hacker* hackerAlt = (Hacker*)arenaAlloc(arena, sizeof(Hacker));
+    if (hackerAlt == NULL){
         return HACKENROLLMENT_ALLOC_FAILED;
     }
-    hacker->hackerAlt->friendsIDs = createHackerFriends(hackers);
-    if (hacker->hackerAlt->friendsIDs == NULL){
-        free(hacker->hackerAlt);
-        destroyQueue(hacker->hackerAlt->desiredCoursesNums, DEFAULT_Q);
+    if (readDesiredCourses(sys, hackers, scratch, scratchCapacity_ptr, hackerAlt) != HACKENROLLMENT_SUCCESS
+    ||  readIDSet(hackers, arena, scratch, scratchCapacity_ptr, &(hackerAlt->friendsIDs)) != HACKENROLLMENT_SUCCESS
+    ||  readIDSet(hackers, arena, scratch, scratchCapacity_ptr, &(hackerAlt->rivalsIDs)) != HACKENROLLMENT_SUCCESS){
         return HACKENROLLMENT_ALLOC_FAILED;
     }
-    hacker->hackerAlt->rivalsIDs = createHackerRivals(hackers);
-    if (hacker->hackerAlt->rivalsIDs == NULL){
-        free(hacker->hackerAlt);
-        destroyQueue(hacker->hackerAlt->desiredCoursesNums, DEFAULT_Q);
-        destroyQueue(hacker->hackerAlt->friendsIDs, DEFAULT_Q);
+    hacker->hackerAlt = hackerAlt; // only complete hackers are attached
+    if (enqueue(sys->hackersQueue, hacker) != HACKENROLLMENT_SUCCESS){
         return HACKENROLLMENT_ALLOC_FAILED;
     }
 
     return HACKENROLLMENT_SUCCESS;
 }
 
-void destroyHacker(Hacker* hacker){
-    if (!hacker) return; // already freed
-    destroyQueue(hacker->desiredCoursesNums, DEFAULT_Q);
-    destroyQueue(hacker->friendsIDs, DEFAULT_Q);
-    destroyQueue(hacker->rivalsIDs, DEFAULT_Q);
-    free(hacker);
-}
+HackEnrollmentError insertHackersInfo(EnrollmentSystem sys, Reader* hackers){
+    if (!sys || !hackers) return HACKENROLLMENT_BAD_PARAM;
+
+    sys->hackersQueue = createQueue(&(sys->arena));
+    if (!(sys->hackersQueue))  return HACKENROLLMENT_ALLOC_FAILED;
 
-HackEnrollmentError insertHackersInfo(Queue students, FILE* hackers){
-    if (!students || !hackers) return HACKENROLLMENT_BAD_PARAM;
+    // course numbers, friends and rivals lines are gathered here before being kept
+    int scratchCapacity = 64;
+    IDSet scratch;
+    scratch.ids = (long*)malloc(scratchCapacity * sizeof(long));
+    if (!(scratch.ids))  return HACKENROLLMENT_ALLOC_FAILED;
 
     long hackerID; Student* hacker;
     bool eol = false;
-    while (!feof(hackers)){
+    HackEnrollmentError result = HACKENROLLMENT_SUCCESS;
+    while (!(hackers->ended)){
         hackerID = readStringIntoLong(hackers, &eol);
         if (eol && hackerID == -1) break;
         eol = false;
-        hacker = (Student*)findStudent(students, students->head, hackerID);
-        if (fillHackerInfo(hacker, hackers) == HACKENROLLMENT_ERROR){
-            return HACKENROLLMENT_ERROR;
+        hacker = findStudent(sys, hackerID);
+        result = fillHackerInfo(sys, hacker, hackers, &scratch, &scratchCapacity);
+        if (result == HACKENROLLMENT_ERROR || result == HACKENROLLMENT_ALLOC_FAILED){
+            break;
         }
+        result = HACKENROLLMENT_SUCCESS;
     }
 
-    return HACKENROLLMENT_SUCCESS;
+    free(scratch.ids);
+    return result;
 }
 
 
 // COURSES
-Course* createCourse(FILE *courses){
+Course* createCourse(Reader* courses, Arena* arena){
     if (!courses) return NULL; // bad parameter
 
     bool eol = false;
-    Course *course_ptr = (Course*)malloc(sizeof(Course));
+    Course *course_ptr = (Course*)arenaAlloc(arena, sizeof(Course));
     if (course_ptr == NULL)  return NULL;
+    course_ptr->courseQueue = NULL; // destroyCourse may run before the line is fully read
+    course_ptr->enrolled = NULL;
+    course_ptr->enrolledCount = 0;
 
     course_ptr->courseNum = readStringIntoLong(courses, &eol);
     if (eol){ // line ended prematurely, bad parameter
@@ -442,27 +848,26 @@ Course* createCourse(FILE *courses){
     return course_ptr;
 }
 
+// destroys the course's queue, the course itself belongs to the arena
 void destroyCourse(Course* course){
     if (!course) return; // already freed
     IsraeliQueueDestroy(course->courseQueue);
-    free(course);
+    course->courseQueue = NULL;
     return;
 }
 
-Queue createCoursesQueue(FILE *courses){
+Queue createCoursesQueue(Reader* courses, Arena* arena){
     if (!courses)  return NULL; // bad parameter
 
-    Queue q = (Queue)malloc(sizeof(Queue_t));
+    Queue q = createQueue(arena);
     if (q == NULL)  return NULL;
 
-    q->head = NULL;
-    q->last = NULL;
-
     Course* cur_course;
-    while (!feof(courses)){
-        cur_course = createCourse(courses);
+    while (!(courses->ended)){
+        cur_course = createCourse(courses, arena);
         if (!cur_course) break;
         if (enqueue(q, cur_course) == HACKENROLLMENT_ALLOC_FAILED){
+            destroyCourse(cur_course);
             destroyQueue(q, COURSES_Q);
             return NULL;
         }
@@ -471,23 +876,190 @@ Queue createCoursesQueue(FILE *courses){
     return q;
 }
 
-Course* findCourse(Queue courses, Node* startingPos, long courseNum){
-    if (!courses || !startingPos)  return NULL; // bad parameters
 
-    Node* curNode = startingPos;
-    Course* curCourse;
-    while (curNode != NULL){
-        curCourse = curNode->element_ptr;
-        if (curCourse == NULL)  return NULL; // error
-        if (curCourse->courseNum == courseNum){
-            return (Course*)(curNode->element_ptr);
+
+// LOADING
+#define LOADER_MAX_THREADS 8              // threads reading parts of the students file, at most
+// the two below can be defined before including this file, a test splits small files on a single processor
+#ifndef STUDENTS_PART_MIN_SIZE
+#define STUDENTS_PART_MIN_SIZE (1 << 20)  // bytes of the students file worth a thread of their own
+#endif
+#ifndef LOADER_PROCESSORS
+#define LOADER_PROCESSORS sysconf(_SC_NPROCESSORS_ONLN) // parts the students file is split into, at most
+#endif
+
+// the courses, read on a thread of their own into an arena of their own
+typedef struct CoursesLoad{
+    Reader* reader;
+    Arena arena;
+    Queue queue;
+    RecordMap map;
+    HackEnrollmentError result;
+} CoursesLoad;
+
+// a part of the mapped students file, whole lines of it, read on a thread of its own into an arena of its own
+typedef struct StudentsPart{
+    MappedFile text; // points into the mapped file, it isn't mapped on its own
+    Arena arena;
+    Queue queue;
+    bool whole; // no student was cut by the end of the part
+    HackEnrollmentError result;
+} StudentsPart;
+
+void* loadCourses(void* load_ptr){
+    CoursesLoad* load = (CoursesLoad*)load_ptr;
+    load->queue = createCoursesQueue(load->reader, &(load->arena));
+    if (load->queue == NULL || buildRecordMap(&(load->map), load->queue, COURSES_Q) != HACKENROLLMENT_SUCCESS){
+        load->result = HACKENROLLMENT_ALLOC_FAILED;
+    }
+    return NULL;
+}
+
+void* loadStudentsPart(void* part_ptr){
+    StudentsPart* part = (StudentsPart*)part_ptr;
+    Reader* reader = createMappedReader(&(part->text));
+    part->queue = createQueue(&(part->arena));
+    if (!reader || !(part->queue)){
+        destroyReader(reader);
+        part->result = HACKENROLLMENT_ALLOC_FAILED;
+        return NULL;
+    }
+
+    // the cities and departments are left in the file, the pool isn't shared between the threads
+    size_t studentsEnd = 0;
+    Student* cur_student;
+    while (!(reader->ended)){
+        cur_student = createStudent(reader, &(part->arena), NULL);
+        if (!cur_student) break;
+        if (enqueue(part->queue, cur_student) == HACKENROLLMENT_ALLOC_FAILED){
+            part->result = HACKENROLLMENT_ALLOC_FAILED;
+            break;
         }
-        curNode = curNode->next;
+        studentsEnd = reader->pos;
     }
 
+    // a digit after the last student starts one more, which could go on in the next part
+    part->whole = true;
+    for (size_t i = studentsEnd; i < part->text.size; i++){
+        if ('0' <= part->text.data[i] && part->text.data[i] <= '9'){
+            part->whole = false;
+            break;
+        }
+    }
+    destroyReader(reader);
     return NULL;
 }
 
+// splits the mapped students file at line ends into up to LOADER_MAX_THREADS parts, one per processor
+// returns the number of parts, 1 when the file is too small to be worth splitting
+int splitStudentsText(Reader* students, StudentsPart* parts){
+    long processors = LOADER_PROCESSORS;
+    size_t count = students->len / STUDENTS_PART_MIN_SIZE;
+    if (processors > 0 && count > (size_t)processors)  count = (size_t)processors;
+    if (count > LOADER_MAX_THREADS)  count = LOADER_MAX_THREADS;
+    if (count < 2)  return 1;
+
+    size_t start = 0, end; int n = 0;
+    const char* lineEnd;
+    for (size_t i = 1; i <= count && start < students->len; i++){
+        end = students->len;
+        if (i < count){ // the part ends after the line it would cut
+            lineEnd = (const char*)memchr(students->buffer + i * (students->len / count), '\n', students->len - i * (students->len / count));
+            if (lineEnd)  end = (size_t)(lineEnd - students->buffer) + 1;
+        }
+        if (end <= start)  continue; // a line longer than a part
+        parts[n].text.data = students->buffer + start;
+        parts[n].text.size = end - start;
+        parts[n].arena.chunks = NULL;
+        parts[n].queue = NULL;
+        parts[n].whole = true;
+        parts[n].result = HACKENROLLMENT_SUCCESS;
+        n++;
+        start = end;
+    }
+
+    return n;
+}
+
+// reads the students of a mapped file in parts on parallel threads, in the order of the file
+// returns HACKENROLLMENT_ERROR if the parts don't match a reading of the whole file, which has to be read at once instead
+HackEnrollmentError loadStudentsInParts(EnrollmentSystem sys, Reader* students){
+    StudentsPart parts[LOADER_MAX_THREADS];
+    int count = splitStudentsText(students, parts);
+    if (count < 2)  return HACKENROLLMENT_ERROR;
+
+    pthread_t threads[LOADER_MAX_THREADS];
+    bool started[LOADER_MAX_THREADS] = { false };
+    for (int i = 1; i < count; i++){
+        started[i] = pthread_create(&(threads[i]), NULL, loadStudentsPart, &(parts[i])) == 0;
+    }
+    loadStudentsPart(&(parts[0])); // this thread reads a part as well
+    for (int i = 1; i < count; i++){
+        if (started[i])  pthread_join(threads[i], NULL);
+        else  loadStudentsPart(&(parts[i])); // no thread for it
+    }
+
+    HackEnrollmentError result = HACKENROLLMENT_SUCCESS;
+    for (int i = 0; i < count; i++){
+        if (parts[i].result != HACKENROLLMENT_SUCCESS)  result = HACKENROLLMENT_ALLOC_FAILED;
+        else if (i < count - 1 && !(parts[i].whole) && result == HACKENROLLMENT_SUCCESS)  result = HACKENROLLMENT_ERROR;
+    }
+    if (result != HACKENROLLMENT_SUCCESS){
+        for (int i = 0; i < count; i++){
+            destroyArena(&(parts[i].arena));
+        }
+        return result;
+    }
+
+    // the parts follow each other in one queue, and their strings are interned like a single reading would
+    sys->studentsQueue = parts[0].queue;
+    sys->studentsQueue->arena = &(sys->arena);
+    for (int i = 0; i < count; i++){
+        adoptArena(&(sys->arena), &(parts[i].arena));
+        if (i == 0 || !(parts[i].queue->head))  continue;
+        if (sys->studentsQueue->head)  sys->studentsQueue->last->next = parts[i].queue->head;
+        else  sys->studentsQueue->head = parts[i].queue->head;
+        sys->studentsQueue->last = parts[i].queue->last;
+    }
+    Student* student;
+    for (Node* cur = sys->studentsQueue->head; cur != NULL; cur = cur->next){
+        student = (Student*)(cur->element_ptr);
+        if (internString(&(sys->strings), student->city, &(student->city)) != HACKENROLLMENT_SUCCESS
+        ||  internString(&(sys->strings), student->department, &(student->department)) != HACKENROLLMENT_SUCCESS){
+            return HACKENROLLMENT_ALLOC_FAILED;
+        }
+    }
+
+    return HACKENROLLMENT_SUCCESS;
+}
+
+// reads the students into the system, a big mapped file in parallel parts
+HackEnrollmentError loadStudents(EnrollmentSystem sys, Reader* students){
+    HackEnrollmentError result = HACKENROLLMENT_ERROR;
+    if (!(students->file)){
+        result = loadStudentsInParts(sys, students);
+    }
+    if (result == HACKENROLLMENT_ERROR){ // read at once
+        sys->studentsQueue = createStudentsQueue(students, &(sys->arena), &(sys->strings));
+        result = sys->studentsQueue ? HACKENROLLMENT_SUCCESS : HACKENROLLMENT_ALLOC_FAILED;
+    }
+    if (result != HACKENROLLMENT_SUCCESS)  return result;
+
+    return buildRecordMap(&(sys->studentsByID), sys->studentsQueue, STUDENTS_Q);
+}
+
+
+
+// EXECUTOR
+// the executor of the system, created with its number of workers on first use, NULL on failure
+Executor getExecutor(EnrollmentSystem sys){
+    if (!(sys->executor)){
+        sys->executor = ExecutorCreate(sys->workers);
+    }
+    return sys->executor;
+}
+
+
 
 // Helper Functions
 Node* findStudentHacker(Queue students, Node* startingPos){
@@ -508,8 +1080,6 @@ Node* findStudentHacker(Queue students, Node* startingPos){
 
 HackEnrollmentError ImproveHackerPositions(EnrollmentSystem sys){
     if (!sys || !(sys->coursesQueue) || !(sys->studentsQueue))    return HACKENROLLMENT_BAD_PARAM;
-    Node* curCourseNumNode;
-    long curCourseNum;
     Course* curCourse;
     Node* curStudentNode = findStudentHacker(sys->studentsQueue, sys->studentsQueue->head);;
     Student* curStudent;
@@ -519,16 +1089,13 @@ HackEnrollmentError ImproveHackerPositions(EnrollmentSystem sys){
                 curStudent = (Student*)(curStudentNode->element_ptr);
             // for Hacker's desired courses
                 curHacker = (Hacker*)(curStudent->hackerAlt);
-                if (!curHacker || !(curHacker->desiredCoursesNums) || !(curHacker->friendsIDs) || !(curHacker->rivalsIDs))
+                if (!curHacker)
                     return HACKENROLLMENT_ERROR;
-                curCourseNumNode = curHacker->desiredCoursesNums->head;
-                while (curCourseNumNode != NULL && curCourseNumNode->element_ptr != NULL){
-                    curCourseNum = *((long*)(curCourseNumNode->element_ptr));
-                    curCourse = findCourse(sys->coursesQueue, sys->coursesQueue->head, curCourseNum);
+                for (int i = 0; i < curHacker->desiredCount; i++){
+                    curCourse = curHacker->desiredCourses[i];
                     if (!curCourse || !(curCourse->courseQueue) || IsraeliQueueEnqueue(curCourse->courseQueue, curStudent) != ISRAELIQUEUE_SUCCESS){
                         return HACKENROLLMENT_ERROR;
                     }
-                    curCourseNumNode = curCourseNumNode->next;
                 }
                 curStudentNode = findStudentHacker(sys->studentsQueue, curStudentNode->next);
         }
@@ -536,140 +1103,182 @@ HackEnrollmentError ImproveHackerPositions(EnrollmentSystem sys){
         return HACKENROLLMENT_SUCCESS;
 }
 
-bool isEnrolled(IsraeliQueue courseQueue, int courseSize, Student* wanted){
-    if (!courseQueue || !wanted)  return false; // bad parameters;
+int compareAddresses(const void* student1, const void* student2){
+    uintptr_t a = (uintptr_t)(*(Student* const*)student1), b = (uintptr_t)(*(Student* const*)student2);
+    return (a > b) - (a < b);
+}
 
-    Student* student = (Student*)IsraeliQueueDequeue(courseQueue);
-    courseSize--;
-    while (student && courseSize > 0){
-        if (student == wanted){
-            return true;
-        }
-        student = (Student*)IsraeliQueueDequeue(courseQueue);
-        courseSize--;
-    }
+// fills the enrolled students of the index-th course, a task of the executor
+void collectEnrolled(void* courses_ptr, int index){
+    Course* course = ((Course**)courses_ptr)[index];
+    course->enrolledCount = IsraeliQueuePeekN(course->courseQueue, (void**)(course->enrolled), course->enrolledCount);
+    qsort(course->enrolled, course->enrolledCount, sizeof(Student*), compareAddresses);
+}
 
-    return false;
+// only the first size students of a course get in
+bool isEnrolled(Course* course, Student* wanted){
+    if (!course || !wanted)  return false; // bad parameters;
+
+    return bsearch(&wanted, course->enrolled, course->enrolledCount, sizeof(Student*), compareAddresses) != NULL;
 }
 
-HackEnrollmentError countEnrollment(EnrollmentSystem sys, Student* student, int* enroll_counter_ptr){
-    if (!sys || !student) return HACKENROLLMENT_BAD_PARAM;
-    if (!student->hackerAlt || !student->hackerAlt->desiredCoursesNums) return HACKENROLLMENT_ERROR;
+HackEnrollmentError countEnrollment(Student* student, int* enroll_counter_ptr){
+    if (!student) return HACKENROLLMENT_BAD_PARAM;
+    if (!student->hackerAlt) return HACKENROLLMENT_ERROR;
 
-    Node* curCourseNumNode = student->hackerAlt->desiredCoursesNums->head;
-    long curCourseNum; Course* curCourse;
-    IsraeliQueue curCourseQueue_cpy;
-    
-    while (curCourseNumNode != NULL || (*enroll_counter_ptr) < 2){
-        if (!curCourseNumNode->element_ptr)  return HACKENROLLMENT_ERROR;
-        curCourseNum = *((long*)(curCourseNumNode->element_ptr));
-        curCourse = findCourse(sys->coursesQueue, sys->coursesQueue->head, curCourseNum);
+    Hacker* hacker = student->hackerAlt;
+    Course* curCourse;
+    for (int i = 0; i < hacker->desiredCount && (*enroll_counter_ptr) < 2; i++){
+        curCourse = hacker->desiredCourses[i];
             if (!curCourse)  return HACKENROLLMENT_ERROR;
 
-        curCourseQueue_cpy = IsraeliQueueClone(curCourse->courseQueue);
-            if (!curCourseQueue_cpy)  return HACKENROLLMENT_ALLOC_FAILED;
-
-        if (isEnrolled(curCourseQueue_cpy, (int)(curCourse->size), student)){
+        if (isEnrolled(curCourse, student)){
             (*(enroll_counter_ptr))++;
         }
-        IsraeliQueueDestroy(curCourseQueue_cpy);
-        curCourseNumNode = curCourseNumNode->next;
     }
     return HACKENROLLMENT_SUCCESS;
 }
 
+// finds the first hacker, in the order of the hackers file, not enrolled in two of the courses asked for
+// (or in the one course asked for). *hackerID_ptr is left as it is if there is none
+// the enrolled students of every course are found once, on parallel threads, before the hackers are checked
 HackEnrollmentError findDissatisfied(EnrollmentSystem sys, long* hackerID_ptr){
-    if (sys == NULL)                                    return HACKENROLLMENT_BAD_PARAM;
-    if (!(sys->studentsQueue) || !(sys->coursesQueue))  return HACKENROLLMENT_ERROR;
-
-    // VARIABLES
-        // HACKER
-        int enroll_counter = 0;
-        Node* hackerNode = findStudentHacker(sys->studentsQueue, sys->studentsQueue->head);
-        Student* hacker; Hacker* hacker_alt;
-        // COURSE
-        Node* curCourseNumNode; long curCourseNum; Course* curCourse;
-
-    // FIND IF ALL HACKERS ARE SATISFIED
-    while (hackerNode != NULL){
-        if (hackerNode->element_ptr != NULL) return HACKENROLLMENT_ERROR;
-        // find hacker
-            hacker = (Student*)(hackerNode->element_ptr);
-            hacker_alt = hacker->hackerAlt;
-            if (!hacker_alt || !(hacker_alt->desiredCoursesNums))
-                return HACKENROLLMENT_ERROR;
-        // going over the desired courses one by one checking enrollment
-            if (countEnrollment(sys, hacker, &enroll_counter) != HACKENROLLMENT_SUCCESS){
-                return HACKENROLLMENT_ERROR;
-            }
-        // check dissatisfaction
-            // exception
-                if (enroll_counter == 1 && hacker_alt->desiredCoursesNums->head == hacker_alt->desiredCoursesNums->last){
-                    continue;
-                }
-            // dissatisfied
-                if (enroll_counter < 2){
-                    if (!(hacker->studentID))  return HACKENROLLMENT_ERROR;
-                    *hackerID_ptr = *(long*)(hacker->studentID);
-                    return HACKENROLLMENT_SUCCESS;
-                }
-        // go to next hacker
-            hackerNode = findStudentHacker(sys->studentsQueue, hackerNode);
-            enroll_counter = 0;
+    if (sys == NULL || !hackerID_ptr)                                               return HACKENROLLMENT_BAD_PARAM;
+    if (!(sys->studentsQueue) || !(sys->coursesQueue) || !(sys->hackersQueue))  return HACKENROLLMENT_ERROR;
+
+    // COURSES: room for the enrolled students of all of them at once
+    int coursesCount = 0; size_t enrolledTotal = 0;
+    Course* course; int queueSize;
+    for (Node* cur = sys->coursesQueue->head; cur != NULL; cur = cur->next){
+        course = (Course*)(cur->element_ptr);
+        if (!course || !(course->courseQueue))  return HACKENROLLMENT_ERROR;
+        queueSize = IsraeliQueueSize(course->courseQueue);
+        course->enrolledCount = course->size < queueSize ? course->size : queueSize;
+        if (course->enrolledCount < 0)  course->enrolledCount = 0;
+        enrolledTotal += course->enrolledCount;
+        coursesCount++;
+    }
+    Course** courses = (Course**)malloc((coursesCount > 0 ? coursesCount : 1) * sizeof(Course*));
+    Student** enrolled = (Student**)malloc((enrolledTotal > 0 ? enrolledTotal : 1) * sizeof(Student*));
+    if (!courses || !enrolled){
+        free(courses);
+        free(enrolled);
+        return HACKENROLLMENT_ALLOC_FAILED;
+    }
+    int i = 0; size_t offset = 0;
+    for (Node* cur = sys->coursesQueue->head; cur != NULL; cur = cur->next, i++){
+        courses[i] = (Course*)(cur->element_ptr);
+        courses[i]->enrolled = enrolled + offset;
+        offset += courses[i]->enrolledCount;
+    }
+    if (!getExecutor(sys) || ExecutorRun(sys->executor, coursesCount, collectEnrolled, courses) != EXECUTOR_SUCCESS){
+        free(courses);
+        free(enrolled);
+        return HACKENROLLMENT_ALLOC_FAILED;
     }
 
-    return HACKENROLLMENT_SUCCESS;
+    // HACKERS: one by one, in the order of the file
+    HackEnrollmentError result = HACKENROLLMENT_SUCCESS;
+    int enroll_counter; Student* hacker;
+    for (Node* hackerNode = sys->hackersQueue->head; hackerNode != NULL; hackerNode = hackerNode->next){
+        hacker = (Student*)(hackerNode->element_ptr);
+        enroll_counter = 0;
+        if (countEnrollment(hacker, &enroll_counter) != HACKENROLLMENT_SUCCESS){
+            result = HACKENROLLMENT_ERROR;
+            break;
+        }
+        if (enroll_counter < 2 && !(enroll_counter == 1 && hacker->hackerAlt->desiredCount == 1)){ // dissatisfied
+            *hackerID_ptr = hacker->studentID;
+            break;
+        }
+    }
+
+    for (i = 0; i < coursesCount; i++){
+        courses[i]->enrolled = NULL;
+        courses[i]->enrolledCount = 0;
+    }
+    free(courses);
+    free(enrolled);
+    return result;
+}
+
+// the line of a course in the out file, written by a task of its own
+typedef struct CourseOutput{
+    Course* course;
+    char* text;
+    size_t length;
+    bool failed;
+} CourseOutput;
+
+#define MAX_NUMBER_LENGTH 21 // a space and the digits of the largest long
+
+// empties the index-th course into its line, a task of the executor
+void writeCourseOutput(void* outputs_ptr, int index){
+    CourseOutput* output = &(((CourseOutput*)outputs_ptr)[index]);
+    Course* course = output->course;
+    if (!course || !(course->courseQueue)){
+        output->failed = true;
+        return;
+    }
+
+    output->text = (char*)malloc(((size_t)IsraeliQueueSize(course->courseQueue) + 1) * MAX_NUMBER_LENGTH + 2);
+    if (!(output->text)){
+        output->failed = true;
+        return;
+    }
+    output->length = (size_t)sprintf(output->text, "%ld", course->courseNum);
+    Student* student;
+    while((student = (Student*)(IsraeliQueueDequeue(course->courseQueue))) != NULL){
+        output->length += (size_t)sprintf(output->text + output->length, " %ld", student->studentID);
+    }
+    output->text[output->length++] = '\n';
 }
 
+// the lines of the courses are written concurrently, then printed in the order of the courses
 HackEnrollmentError printOut(EnrollmentSystem sys, FILE* out){
     if (!sys || !out)           return HACKENROLLMENT_BAD_PARAM;
     if (!(sys->coursesQueue))   return HACKENROLLMENT_ERROR;
 
-    // VARIABLES
-        // COURSE
-        Node* courseNode = sys->coursesQueue->head;
-        Course* curCourse;
-        // STUDENT
-        Node* studentNode;
-        Student* student;
-        long cur_studentID;
-
-    while(courseNode){
-        curCourse = (Course*)(courseNode->element_ptr);
-        if (!curCourse || !(curCourse->courseQueue)) return HACKENROLLMENT_ERROR;
+    int coursesCount = 0;
+    for (Node* courseNode = sys->coursesQueue->head; courseNode != NULL; courseNode = courseNode->next){
+        coursesCount++;
+    }
+    CourseOutput* outputs = (CourseOutput*)malloc((coursesCount > 0 ? coursesCount : 1) * sizeof(CourseOutput));
+    if (!outputs)  return HACKENROLLMENT_ALLOC_FAILED;
+    int i = 0;
+    for (Node* courseNode = sys->coursesQueue->head; courseNode != NULL; courseNode = courseNode->next, i++){
+        outputs[i].course = (Course*)(courseNode->element_ptr);
+        outputs[i].text = NULL;
+        outputs[i].length = 0;
+        outputs[i].failed = false;
+    }
 
-        fprintf(out, "%ld", curCourse->courseNum);
-        studentNode = (Node*)(IsraeliQueueDequeue(curCourse->courseQueue));
-        while(studentNode){
-            student = (Student*)(studentNode->element_ptr);
-            if (!student)   return HACKENROLLMENT_ERROR;
-            fprintf(out, " %ld", student->studentID);
-            studentNode = studentNode->next;
+    HackEnrollmentError result = HACKENROLLMENT_SUCCESS;
+    if (!getExecutor(sys) || ExecutorRun(sys->executor, coursesCount, writeCourseOutput, outputs) != EXECUTOR_SUCCESS){
+        result = HACKENROLLMENT_ALLOC_FAILED;
+    }
+    for (i = 0; i < coursesCount && result == HACKENROLLMENT_SUCCESS; i++){
+        if (outputs[i].failed){
+            result = HACKENROLLMENT_ERROR;
+            break;
         }
-        fprintf(out, "\n");
-        courseNode = courseNode->next; 
+        fwrite(outputs[i].text, sizeof(char), outputs[i].length, out);
     }
 
-    return HACKENROLLMENT_SUCCESS;
+    for (i = 0; i < coursesCount; i++){
+        free(outputs[i].text);
+    }
+    free(outputs);
+    return result;
 }
 
 
 // Friendship
-// finds if the wanted ID is a part of the given queue of student IDs
-bool findStudentInIDQueue(Queue studentsIDs, long wantedID){
-    if (!studentsIDs) return false; // bad parameters
+// finds if the wanted ID is a part of the given set of student IDs
+bool findStudentInIDSet(const IDSet* studentsIDs, long wantedID){
+    if (!studentsIDs || studentsIDs->size == 0) return false; // bad parameters or empty set
 
-    Node* curStudentIDNode = studentsIDs->head;
-    long* curStudentID;
-    while (curStudentIDNode){
-        curStudentID = (long*)(curStudentIDNode->element_ptr);
-        if (!curStudentID) return false; // error
-        if ((*curStudentID) == wantedID){
-            return true;
-        }
-        curStudentIDNode = curStudentIDNode->next;
-    }
-    return false;
+    return bsearch(&wantedID, studentsIDs->ids, studentsIDs->size, sizeof(long), compareIDs) != NULL;
 }
 
 // returns the absolute value of a long
@@ -679,11 +1288,11 @@ long absL(long n){
 }
 
 // finds the ascii value of a word, returning -1 if bad parameter
-long findStringAscii(char* s){
-    if (!s) return -1;
+long findStringAscii(StringView s){
+    if (!(s.chars)) return -1;
     long value = 0;
-    for (int i = 0; s[i] != '\0'; i++){
-        value += s[i];
+    for (size_t i = 0; i < s.length; i++){
+        value += s.chars[i];
     }
     return value;
 }
@@ -694,18 +1303,18 @@ int areFriendsAccordingToHacker(void* student1, void* student2){
     if (!(Student*)student1 || !(Student*)student2) return 0; // bad parameters
 
     if (((Student*)student1)->hackerAlt){
-        if (findStudentInIDQueue(((Student*)student1)->hackerAlt->friendsIDs, ((Student*)student2)->studentID)){
+        if (findStudentInIDSet(&(((Student*)student1)->hackerAlt->friendsIDs), ((Student*)student2)->studentID)){
             return 20;
         }
-        else if (findStudentInIDQueue(((Student*)student1)->hackerAlt->rivalsIDs, ((Student*)student2)->studentID)){
+        else if (findStudentInIDSet(&(((Student*)student1)->hackerAlt->rivalsIDs), ((Student*)student2)->studentID)){
             return -20;
         }
     }
     else if (((Student*)student2)->hackerAlt){
-        if (findStudentInIDQueue(((Student*)student2)->hackerAlt->friendsIDs, ((Student*)student1)->studentID)){
+        if (findStudentInIDSet(&(((Student*)student2)->hackerAlt->friendsIDs), ((Student*)student1)->studentID)){
             return 20;
         }
-        else if (findStudentInIDQueue(((Student*)student2)->hackerAlt->rivalsIDs, ((Student*)student1)->studentID)){
+        else if (findStudentInIDSet(&(((Student*)student2)->hackerAlt->rivalsIDs), ((Student*)student1)->studentID)){
             return -20;
         }
     }
@@ -717,8 +1326,8 @@ int areFriendsAccordingToHacker(void* student1, void* student2){
 // returns -1 if bad parameters
 int findNameAsciiDifference(void* student1, void* student2){
     if (!student1 || !student2) return -1;
-    long value1 = findStringAscii(((Student*)student1)->name);
-    long value2 = findStringAscii(((Student*)student2)->name);
+    long value1 = ((Student*)student1)->nameAscii;
+    long value2 = ((Student*)student2)->nameAscii;
     
     return ((int)(absL(value1 - value2)));
 }
@@ -735,43 +1344,180 @@ int findIDDifference(void* student1, void* student2){
 
 
 // Functions
+HackEnrollmentError setEnrollmentWorkers(EnrollmentSystem sys, int workers){
+    if (!sys || workers < 0)  return HACKENROLLMENT_BAD_PARAM;
+
+    ExecutorDestroy(sys->executor); // the next one is made with the new number of workers
+    sys->executor = NULL;
+    sys->workers = workers;
+    return HACKENROLLMENT_SUCCESS;
+}
+
 void destroyEnrollment(EnrollmentSystem sys){
     if (!sys) return; // already freed
+    ExecutorDestroy(sys->executor);
     destroyQueue(sys->coursesQueue, COURSES_Q);
-    destroyQueue(sys->studentsQueue, STUDENTS_Q);
+    free(sys->studentsByID.entries);
+    free(sys->coursesByNum.entries);
+    unmapFile(&(sys->studentsText));
+    destroyStringPool(&(sys->strings));
+    destroyArena(&(sys->arena)); // every student, hacker, course and node at once
     free(sys);
 }
 
-EnrollmentSystem createEnrollment(FILE *students, FILE *courses, FILE *hackers){
+// reads the three files into an empty system
+HackEnrollmentError fillEnrollment(EnrollmentSystem enrollment, Reader* students, Reader* courses, Reader* hackers){
+    // Initialize and Fill up the students and courses queues, the courses on a thread of their own
+    CoursesLoad coursesLoad;
+    coursesLoad.reader = courses;
+    coursesLoad.arena.chunks = NULL;
+    coursesLoad.queue = NULL;
+    coursesLoad.map.entries = NULL;
+    coursesLoad.result = HACKENROLLMENT_SUCCESS;
+    pthread_t coursesThread;
+    bool threaded = pthread_create(&coursesThread, NULL, loadCourses, &coursesLoad) == 0;
+    if (!threaded)  loadCourses(&coursesLoad);
+
+    HackEnrollmentError studentsResult = loadStudents(enrollment, students);
+
+    if (threaded)  pthread_join(coursesThread, NULL);
+    adoptArena(&(enrollment->arena), &(coursesLoad.arena));
+    enrollment->coursesQueue = coursesLoad.queue;
+    enrollment->coursesByNum = coursesLoad.map;
+    if (enrollment->coursesQueue)  enrollment->coursesQueue->arena = &(enrollment->arena);
+    if (studentsResult != HACKENROLLMENT_SUCCESS || coursesLoad.result != HACKENROLLMENT_SUCCESS ||
+        students->failed || courses->failed){
+        return HACKENROLLMENT_ALLOC_FAILED;
+    }
+
+    // Fill up hackers details
+    if (insertHackersInfo(enrollment, hackers) == HACKENROLLMENT_ALLOC_FAILED || hackers->failed){
+        return HACKENROLLMENT_ALLOC_FAILED;
+    }
+
+    return HACKENROLLMENT_SUCCESS;
+}
+
+// creates a system from the three readers, NULL on failure
+EnrollmentSystem createEnrollmentFromReaders(Reader* students, Reader* courses, Reader* hackers){
     if (!students || !courses || !hackers)  return NULL; // bad parameters
 
     // Create a new EnrollmentSystem
     EnrollmentSystem enrollment = (EnrollmentSystem)malloc(sizeof(EnrollmentSystem_t));
     if (enrollment == NULL)  return NULL;
-
-    // Initialize and Fill up the students and courses queues
-    enrollment->studentsQueue = createStudentsQueue(students);
-    if (enrollment->studentsQueue == NULL){
+    enrollment->studentsQueue = NULL;
+    enrollment->coursesQueue = NULL;
+    enrollment->hackersQueue = NULL;
+    enrollment->executor = NULL;
+    enrollment->workers = EXECUTOR_DEFAULT_WORKERS;
+    enrollment->studentsByID.entries = NULL;
+    enrollment->coursesByNum.entries = NULL;
+    enrollment->studentsText.data = NULL;
+    enrollment->studentsText.size = 0;
+    enrollment->arena.chunks = NULL;
+    enrollment->strings.arena = &(enrollment->arena);
+    enrollment->strings.entries = NULL;
+    enrollment->strings.mask = 0;
+    enrollment->strings.used = 0;
+
+    if (fillEnrollment(enrollment, students, courses, hackers) != HACKENROLLMENT_SUCCESS){
         destroyEnrollment(enrollment);
         return NULL;
     }
 
-    enrollment->coursesQueue = createCoursesQueue(courses);
-    if (enrollment->coursesQueue == NULL){
-        destroyEnrollment(enrollment);
+    return enrollment;
+}
+
+EnrollmentSystem createEnrollment(FILE *students, FILE *courses, FILE *hackers){
+    if (!students || !courses || !hackers)  return NULL; // bad parameters
+
+    Reader* studentsReader = createReader(students);
+    Reader* coursesReader = createReader(courses);
+    Reader* hackersReader = createReader(hackers);
+    EnrollmentSystem enrollment = createEnrollmentFromReaders(studentsReader, coursesReader, hackersReader);
+    destroyReader(studentsReader);
+    destroyReader(coursesReader);
+    destroyReader(hackersReader);
+
+    return enrollment;
+}
+
+EnrollmentSystem createEnrollmentFromPaths(const char* students, const char* courses, const char* hackers){
+    if (!students || !courses || !hackers)  return NULL; // bad parameters
+
+    MappedFile studentsFile, coursesFile, hackersFile;
+    if (mapFile(students, &studentsFile) != HACKENROLLMENT_SUCCESS)  return NULL;
+    if (mapFile(courses, &coursesFile) != HACKENROLLMENT_SUCCESS){
+        unmapFile(&studentsFile);
         return NULL;
     }
-
-    // Fill up hackers details
-    if (insertHackersInfo(enrollment->studentsQueue, hackers) == HACKENROLLMENT_ALLOC_FAILED){
-        destroyEnrollment(enrollment);
+    if (mapFile(hackers, &hackersFile) != HACKENROLLMENT_SUCCESS){
+        unmapFile(&studentsFile);
+        unmapFile(&coursesFile);
         return NULL;
     }
 
+    Reader* studentsReader = createMappedReader(&studentsFile);
+    Reader* coursesReader = createMappedReader(&coursesFile);
+    Reader* hackersReader = createMappedReader(&hackersFile);
+    EnrollmentSystem enrollment = createEnrollmentFromReaders(studentsReader, coursesReader, hackersReader);
+    destroyReader(studentsReader);
+    destroyReader(coursesReader);
+    destroyReader(hackersReader);
+    // only numbers were read from these two, nothing points into them
+    unmapFile(&coursesFile);
+    unmapFile(&hackersFile);
+
+    if (!enrollment){
+        unmapFile(&studentsFile);
+        return NULL;
+    }
+    enrollment->studentsText = studentsFile; // the students' strings point into it
     return enrollment;
 }
 
-EnrollmentSystem readEnrollment(EnrollmentSystem sys, FILE* queues){
+// a line of the queues file: its course and its students, which are kept one line after the other
+typedef struct QueueLine{
+    Course* course;
+    int start; // index of the first student of the line, lines later in the file start later
+    int size;
+    bool failed;
+} QueueLine;
+
+// the lines of the queues file sorted by course, the lines of a course in the order of the file
+typedef struct QueueLines{
+    QueueLine* lines;
+    int* groups;  // the index-th course has lines groups[index] to groups[index + 1] - 1
+    Student** students;
+} QueueLines;
+
+int compareQueueLines(const void* line1, const void* line2){
+    const QueueLine* a = (const QueueLine*)line1; const QueueLine* b = (const QueueLine*)line2;
+    uintptr_t courseA = (uintptr_t)(a->course), courseB = (uintptr_t)(b->course);
+    if (courseA != courseB)  return (courseA > courseB) - (courseA < courseB);
+    return (a->start > b->start) - (a->start < b->start);
+}
+
+// enqueues the lines of the index-th course one after the other, a task of the executor
+void enqueueCourseLines(void* lines_ptr, int index){
+    QueueLines* queueLines = (QueueLines*)lines_ptr;
+    QueueLine* line; IsraeliQueue courseQueue;
+    for (int i = queueLines->groups[index]; i < queueLines->groups[index + 1]; i++){
+        line = &(queueLines->lines[i]);
+        courseQueue = line->course->courseQueue;
+        if (IsraeliQueueEnqueueBatch(courseQueue, (void**)(queueLines->students + line->start), line->size) != ISRAELIQUEUE_SUCCESS
+        ||  IsraeliQueueAddFriendshipMeasure(courseQueue, areFriendsAccordingToHacker) != ISRAELIQUEUE_SUCCESS
+        ||  IsraeliQueueAddFriendshipMeasure(courseQueue, findNameAsciiDifference)
+        ||  IsraeliQueueAddFriendshipMeasure(courseQueue, findIDDifference)){
+            line->failed = true;
+            return;
+        }
+    }
+}
+
+// fills the course queues from the reader, frees the system on failure
+// the file is read first, then the courses are filled concurrently, each with its lines in the order of the file
+EnrollmentSystem readEnrollmentFromReader(EnrollmentSystem sys, Reader* queues){
     if (!sys || !(sys->coursesQueue) || !(sys->studentsQueue) || !queues){ // bad parameters
         destroyEnrollment(sys); // preventing memory leakage
         return NULL;
@@ -779,36 +1525,105 @@ EnrollmentSystem readEnrollment(EnrollmentSystem sys, FILE* queues){
 
     Course* curCourse; long curCourseNum;
     bool eol = false;
-    Student* curStudent; long cur_studentID;
-    while(!feof(queues)){
+    long cur_studentID;
+    int linesCapacity = 16, linesCount = 0;
+    int studentsCapacity = 64, studentsCount = 0;
+    QueueLines queueLines;
+    queueLines.lines = (QueueLine*)malloc(linesCapacity * sizeof(QueueLine));
+    queueLines.students = (Student**)malloc(studentsCapacity * sizeof(Student*));
+    queueLines.groups = NULL;
+    void* tmp;
+    bool failed = !(queueLines.lines) || !(queueLines.students);
+    while(!failed && !(queues->ended)){
         curCourseNum = readStringIntoLong(queues, &eol);
         if (eol && curCourseNum == -1) break; // end
         eol = false; // reset for eol
-        curCourse = findCourse(sys->coursesQueue, sys->coursesQueue->head, curCourseNum);
+        curCourse = findCourse(sys, curCourseNum);
         if(!curCourse || !(curCourse->courseQueue)){ // error
-            destroyEnrollment(sys); // preventing memory leakage
-            return NULL;
+            failed = true;
+            break;
+        }
+        if (linesCount == linesCapacity){
+            tmp = realloc(queueLines.lines, 2 * linesCapacity * sizeof(QueueLine));
+            if (!tmp){
+                failed = true;
+                break;
+            }
+            queueLines.lines = (QueueLine*)tmp;
+            linesCapacity *= 2;
         }
+        queueLines.lines[linesCount].course = curCourse;
+        queueLines.lines[linesCount].start = studentsCount;
+        queueLines.lines[linesCount].failed = false;
         while(!eol){
             cur_studentID = readStringIntoLong(queues, &eol);
             if (eol && cur_studentID == -1) break; // end
-            curStudent = findStudent(sys->studentsQueue, sys->studentsQueue->head, cur_studentID);
-            if (IsraeliQueueEnqueue(curCourse->courseQueue, curStudent) != ISRAELIQUEUE_SUCCESS){
-                destroyEnrollment(sys); // preventing memory leakage
-                return NULL;
+            if (studentsCount == studentsCapacity){
+                tmp = realloc(queueLines.students, 2 * studentsCapacity * sizeof(Student*));
+                if (!tmp){
+                    failed = true;
+                    break;
+                }
+                queueLines.students = (Student**)tmp;
+                studentsCapacity *= 2;
             }
-
+            queueLines.students[studentsCount++] = findStudent(sys, cur_studentID);
         }
+        queueLines.lines[linesCount].size = studentsCount - queueLines.lines[linesCount].start;
+        linesCount++;
         eol = false; // reset for eol
-        if (IsraeliQueueAddFriendshipMeasure(curCourse->courseQueue, areFriendsAccordingToHacker) != ISRAELIQUEUE_SUCCESS
-        ||  IsraeliQueueAddFriendshipMeasure(curCourse->courseQueue, findNameAsciiDifference)
-        ||  IsraeliQueueAddFriendshipMeasure(curCourse->courseQueue, findIDDifference)){
-                destroyEnrollment(sys); // preventing memory leakage
-                return NULL;
+    }
+    failed = failed || queues->failed; // the rest of the file wasn't read
+
+    // one group of lines per course
+    int coursesCount = 0;
+    if (!failed){
+        qsort(queueLines.lines, linesCount, sizeof(QueueLine), compareQueueLines);
+        queueLines.groups = (int*)malloc((linesCount + 1) * sizeof(int));
+        failed = !(queueLines.groups);
+    }
+    for (int i = 0; !failed && i < linesCount; i++){
+        if (i == 0 || queueLines.lines[i].course != queueLines.lines[i - 1].course){
+            queueLines.groups[coursesCount++] = i;
         }
+    }
+    if (!failed){
+        queueLines.groups[coursesCount] = linesCount;
+        failed = !getExecutor(sys) || ExecutorRun(sys->executor, coursesCount, enqueueCourseLines, &queueLines) != EXECUTOR_SUCCESS;
+    }
+    for (int i = 0; !failed && i < linesCount; i++){
+        failed = queueLines.lines[i].failed;
+    }
+
+    free(queueLines.lines);
+    free(queueLines.students);
+    free(queueLines.groups);
+    if (failed){
+        destroyEnrollment(sys); // preventing memory leakage
+        return NULL;
+    }
+    return sys;
+}
 
+EnrollmentSystem readEnrollment(EnrollmentSystem sys, FILE* queuesFile){
+    Reader* queues = createReader(queuesFile);
+    sys = readEnrollmentFromReader(sys, queues);
+    destroyReader(queues);
 
+    return sys;
+}
+
+EnrollmentSystem readEnrollmentFromPath(EnrollmentSystem sys, const char* queuesPath){
+    MappedFile queuesFile;
+    if (mapFile(queuesPath, &queuesFile) != HACKENROLLMENT_SUCCESS){
+        destroyEnrollment(sys); // preventing memory leakage
+        return NULL;
     }
+    Reader* queues = createMappedReader(&queuesFile);
+    sys = readEnrollmentFromReader(sys, queues);
+    destroyReader(queues);
+    unmapFile(&queuesFile);
+
     return sys;
 }
 
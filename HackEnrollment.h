@@ -26,6 +26,15 @@ In case of failure, returns NULL.
 */
 EnrollmentSystem createEnrollment(FILE *students, FILE *courses, FILE *hackers);
 
+/*
+same as createEnrollment, with the paths of the Students, Courses and Hackers Files instead of open files.
+the files are mapped into memory and parsed in place: the names, surnames, cities and departments of the students
+point into the mapped Students File, which stays mapped until the object is destroyed, instead of being copied.
+a big Students File is read in parts on parallel threads, with the same students in the same order.
+In case of failure, returns NULL.
+*/
+EnrollmentSystem createEnrollmentFromPaths(const char* students, const char* courses, const char* hackers);
+
 
 /*
 updates a given EnrollmentSystem_t (provided by its pointer) with the enrollment queues for the courses provided previously by the Courses File.
@@ -34,6 +43,12 @@ In case of failure, frees the object, preventing memory leakage, and returns NUL
 */
 EnrollmentSystem readEnrollment(EnrollmentSystem sys, FILE* queues);
 
+/*
+same as readEnrollment, with the path of the Queues File, which is mapped into memory and parsed in place.
+In case of failure, frees the object, preventing memory leakage, and returns NULL.
+*/
+EnrollmentSystem readEnrollmentFromPath(EnrollmentSystem sys, const char* queues);
+
 /*
 writes to the Out File the new enrollment queues for the courses provided previously by the Courses File, with every hacker enrolled to at least two of the courses he asked for (located within <Size). Otherwise, the message “Cannot satisfy constraints for <Student ID> ” is printed out, with  <Student ID> being the ID of the first unsatisfied hacker according to the Hackers File.
 The hackers are added to each course according to:
@@ -42,6 +57,14 @@ The hackers are added to each course according to:
 */
 HackEnrollmentError hackEnrollment(EnrollmentSystem sys, FILE* out);
 
+/*
+sets the number of threads working on the courses of a given EnrollmentSystem_t (provided by its pointer) concurrently,
+in readEnrollment, hackEnrollment and its print out. 0 (the default) means one per processor. 1 runs everything
+on the calling thread in the order of the courses, which is deterministic and meant for debugging.
+In case of a NULL object or a negative number, returns HACKENROLLMENT_BAD_PARAM.
+*/
+HackEnrollmentError setEnrollmentWorkers(EnrollmentSystem sys, int workers);
+
 /*
 destroys a given EnrollmentSystem_t (provided by its pointer)
 */
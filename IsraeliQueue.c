@@ -1,4 +1,10 @@
 #include "IsraeliQueue.h"
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <limits.h>
+#include <pthread.h>
 
 typedef struct israeliNode {
    void* element_ptr;
@@ -9,52 +15,245 @@ typedef struct israeliNode {
 
 } israeliNode;
 
+// a block of nodes allocated at once by the node pool
+typedef struct israeliSlab {
+    struct israeliSlab* next;
+    israeliNode nodes[];
+} israeliSlab;
+
+typedef struct israeliNodePool {
+    israeliSlab* slabs;       // newest slab first
+    int usedInSlab;           // nodes of the newest slab handed out so far
+    israeliNode* freeNodes;   // recycled nodes, linked through their next pointers
+    IsraeliQueuePoolStats stats;
+} israeliNodePool;
+
+// ISRAELIQUEUE_STORAGE_ARRAY: the queue occupies indices [front, front + size) of three parallel arrays
+typedef struct israeliArray {
+    void** elements;
+    int* friendsPassed;
+    int* rivalsBlocked;
+    int* tags;      // only while improving positions: the original position of every element
+    int front;
+    int capacity;
+} israeliArray;
+
+// both relations of a pair, derived from a single evaluation of every friendship function
+typedef struct israeliVerdict {
+    bool friends;
+    bool rivals;
+} israeliVerdict;
+
+// a remembered verdict, only valid while its generation is the cache's current one
+typedef struct israeliCacheEntry {
+    void* item1;
+    void* item2;
+    unsigned int generation;
+    israeliVerdict verdict;
+} israeliCacheEntry;
+
+// direct-mapped: every pair has a single slot, a newer pair simply replaces the older one
+typedef struct israeliPairCache {
+    israeliCacheEntry* entries;
+    size_t mask;             // number of entries - 1
+    unsigned int generation; // bumped to forget every entry at once, entries start at 0 (empty)
+    IsraeliQueueCacheStats stats;
+} israeliPairCache;
+
+// reads the elements of a queue in order without changing it, the shared elements of a snapshot included
+typedef struct israeliCursor {
+    struct IsraeliQueue_t* owner; // the queue storing the elements
+    israeliNode* node;            // next node, LIST storage
+    int index;                    // next position in the arrays (not counted from the front), ARRAY storage
+    int remaining;
+} israeliCursor;
+
+// an input queue of a merge and how much of it was taken
+typedef struct israeliMergeInput {
+    IsraeliQueue q;
+    israeliCursor cursor; // only read when keeping the inputs
+} israeliMergeInput;
+
+// one distinct element pointer of the queue, count is how many times it is in the queue (0 for an empty slot)
+typedef struct israeliIndexEntry {
+    void* element;
+    unsigned long hash;
+    int count;
+} israeliIndexEntry;
+
+// what a scan made without headLock found: the rivals of the item, charged only once the item is placed,
+// and the position of the node found for it, which is still valid as long as fewer nodes were dequeued
+typedef struct israeliCharges {
+    struct israeliNode** nodes;
+    int count;
+    int capacity;
+    int foremostIndex;
+} israeliCharges;
+
+// the synchronization of a concurrent queue
+// writeLock is held by every change of the queue except a dequeue, headLock by every change of the list
+// itself (a dequeue, or placing a scanned item) and by every read of it; writeLock is always taken first
+// nodes are allocated under writeLock only and freed under headLock only, so a concurrent queue can't have
+// a node pool, and dequeues don't update a pair cache or hash index: see hasDefaultOptions
+typedef struct israeliConcurrency {
+    pthread_mutex_t writeLock;
+    pthread_mutex_t headLock;
+    unsigned long dequeues; // dequeues so far, telling an enqueue how many happened during its scan
+    bool scanning;          // an enqueue is scanning the list without headLock
+    israeliCharges charges; // what the current scan found
+} israeliConcurrency;
+
+// open addressing with linear probing, so all the entries of a hash are in one run of full slots
+typedef struct israeliMembershipIndex {
+    israeliIndexEntry* entries;
+    size_t mask;  // number of slots - 1
+    size_t used;  // full slots
+} israeliMembershipIndex;
+
 typedef struct IsraeliQueue_t {
     israeliNode* head;
     israeliNode* last;
-    FriendshipFunction* FriendshipFuncs;
+    FriendshipFunction* FriendshipFuncs; // NULL terminated, a function added several times appears that many times
     ComparisonFunction ComparisonFunc;
     int friendshipThreshold;
     int rivalryThreshold;
+    int size; // number of nodes, kept up to date by every insertion and removal
+    IsraeliQueueOptions options;
+    israeliNodePool pool; // unused unless options.nodePoolSlabSize > 0
+    israeliArray array;   // unused unless options.storage == ISRAELIQUEUE_STORAGE_ARRAY
+    israeliPairCache cache; // unused unless options.pairCacheSize > 0
+    israeliMembershipIndex index; // unused unless options.hashFunc != NULL
+    israeliNode* retired; // dequeued nodes still read by a concurrent scan or by snapshots, linked through previous
+    // SNAPSHOTS
+    struct IsraeliQueue_t* source;       // a snapshot still sharing its elements: the queue storing them, NULL otherwise
+    israeliCursor shared;                // a snapshot still sharing its elements: where they start in source
+    struct IsraeliQueue_t* snapshots;    // the snapshots sharing this queue's elements
+    struct IsraeliQueue_t* nextSnapshot; // the next snapshot sharing the same source
+    israeliConcurrency* concurrency; // NULL unless created by IsraeliQueueCreateConcurrent
 } IsraeliQueue_t;
 
 // HELPER FUNCTIONS DECLARATIONS
-bool areFriends(IsraeliQueue q, void* item1, void* item2);
-bool areRivals(IsraeliQueue q, void* item1, void* item2);
-israeliNode* findForemostPos(IsraeliQueue q, void* item);
-israeliNode* insertItem(IsraeliQueue q, israeliNode* foremostPos, void* item);
-IsraeliQueueError insertIsraeliNode(IsraeliQueue q, israeliNode* foremostPos, israeliNode* item_israeliNode);
-israeliNode* findPrevious(IsraeliQueue q, israeliNode* cur);
-bool isMergeDone(IsraeliQueue* qArr);
-int abs(int n);
-unsigned int power(int n, int exp);
-int findNRoot(unsigned int num, int n);
+israeliNode* allocNode(IsraeliQueue q);
+void freeNode(IsraeliQueue q, israeliNode* node);
+void destroyNodePool(israeliNodePool* pool);
+israeliVerdict evaluatePair(IsraeliQueue q, void* item1, void* item2);
+israeliVerdict scorePair(IsraeliQueue q, void* item1, void* item2);
+IsraeliQueueError addFriendshipFunction(IsraeliQueue q, FriendshipFunction func);
+IsraeliQueueError copyFriendshipFunctions(IsraeliQueue dest, IsraeliQueue src);
+IsraeliQueueError createPairCache(israeliPairCache* cache, int size);
+void invalidatePairCache(IsraeliQueue q);
+size_t indexSlot(israeliMembershipIndex* index, unsigned long hash);
+IsraeliQueueError growIndex(israeliMembershipIndex* index);
+IsraeliQueueError addToIndex(IsraeliQueue q, void* element);
+void removeFromIndex(IsraeliQueue q, void* element);
+bool indexContains(IsraeliQueue q, void* element);
+israeliNode* findForemostPos(IsraeliQueue q, void* item, bool* lastIsFriend_ptr);
+israeliNode* scanForemostPos(IsraeliQueue q, void* item, israeliNode* head, israeliNode* last, israeliCharges* charges,
+                             bool* lastIsFriend_ptr);
+israeliNode* insertItem(IsraeliQueue q, israeliNode* foremostPos, void* item, bool lastIsFriend);
+IsraeliQueueError insertIsraeliNode(IsraeliQueue q, israeliNode* foremostPos, israeliNode* item_israeliNode, bool lastIsFriend);
+bool isArrayStorage(IsraeliQueue q);
+int findForemostIndex(IsraeliQueue q, void* item, bool* lastIsFriend_ptr);
+void moveArrayBlock(israeliArray* arr, int to, int from, int count);
+IsraeliQueueError growArray(IsraeliQueue q, int minCapacity);
+IsraeliQueueError openArraySlot(IsraeliQueue q, int at);
+IsraeliQueueError placeInArray(IsraeliQueue q, int foremostIndex, void* item, int friendsPassed, int rivalsBlocked, bool lastIsFriend);
+IsraeliQueueError improvePositionsArray(IsraeliQueue q);
+void unlinkIsraeliNode(IsraeliQueue q, israeliNode* node);
+IsraeliQueueError enqueueItem(IsraeliQueue q, void* item);
+void startCursor(israeliCursor* cursor, IsraeliQueue q);
+void* cursorNext(israeliCursor* cursor, int* friendsPassed_ptr, int* rivalsBlocked_ptr);
+IsraeliQueueError copyElements(IsraeliQueue dest, israeliCursor* cursor);
+void freeElements(IsraeliQueue q);
+void removeSnapshot(IsraeliQueue q);
+IsraeliQueueError ownElements(IsraeliQueue q);
+IsraeliQueueError prepareWrite(IsraeliQueue q);
+void* nextMergeItem(israeliMergeInput* input, bool keepInputs);
+IsraeliQueue mergeQueues(IsraeliQueue* qArr, ComparisonFunction ComparisonFunc, bool keepInputs);
+uint64_t absThreshold(int n);
+uint64_t power(uint64_t n, int exp);
+uint64_t findNRoot(uint64_t num, int n);
+uint64_t findLogNRoot(long double logSum, int n);
 int findMergedFriendshipThreshold(IsraeliQueue* qArr);
 int findMergedRivalryThreshold(IsraeliQueue* qArr);
+void lockWriter(IsraeliQueue q);
+void unlockWriter(IsraeliQueue q);
+void lockHead(IsraeliQueue q);
+void unlockHead(IsraeliQueue q);
+void freeRetired(IsraeliQueue q);
+bool hasDefaultOptions(IsraeliQueue q);
+IsraeliQueueError enqueueConcurrent(IsraeliQueue q, void* item);
+void* dequeueConcurrent(IsraeliQueue q);
+IsraeliQueue cloneQueue(IsraeliQueue q);
+bool containsElement(IsraeliQueue q, void* element);
+int peekElements(IsraeliQueue q, void** out, int n);
+int indexOfElement(IsraeliQueue q, void* item, int limit);
+IsraeliQueueError improvePositions(IsraeliQueue q);
+#ifndef NDEBUG
+int countIsraeliNodes(IsraeliQueue q);
+#endif
 
 /**Creates a new IsraeliQueue_t object with the provided friendship functions, a NULL-terminated array,
  * comparison function, friendship threshold and rivalry threshold. Returns a pointer
  * to the new object. In case of failure, return NULL.*/
 IsraeliQueue IsraeliQueueCreate(FriendshipFunction* FriendshipFuncs, ComparisonFunction ComparisonFunc, int friendshipThreshold, int rivalryThreshold){
+    return IsraeliQueueCreateWithOptions(FriendshipFuncs, ComparisonFunc, friendshipThreshold, rivalryThreshold, NULL);
+}
+
+/**Same as IsraeliQueueCreate, with the additional settings described in IsraeliQueueOptions.
+ * A NULL options pointer is the same as IsraeliQueueCreate. In case of failure, return NULL.*/
+IsraeliQueue IsraeliQueueCreateWithOptions(FriendshipFunction* FriendshipFuncs, ComparisonFunction ComparisonFunc,
+                                           int friendshipThreshold, int rivalryThreshold, const IsraeliQueueOptions* options){
     if (FriendshipFuncs == NULL) return NULL; // bad parameter
+    if (options && (options->nodePoolSlabSize < 0 || options->pairCacheSize < 0 ||
+        (options->storage != ISRAELIQUEUE_STORAGE_LIST && options->storage != ISRAELIQUEUE_STORAGE_ARRAY))){
+        return NULL; // bad parameter
+    }
     IsraeliQueue q = (IsraeliQueue)malloc(sizeof(IsraeliQueue_t));
     if (q == NULL) return NULL;
 
     q->head = NULL;
     q->last = NULL;
+    q->size = 0;
     q->ComparisonFunc = ComparisonFunc;
     q->friendshipThreshold = friendshipThreshold;
     q->rivalryThreshold = rivalryThreshold;
 
+    IsraeliQueueOptions defaultOptions = { 0 };
+    q->options = options ? *options : defaultOptions;
+    q->pool.slabs = NULL;
+    q->pool.usedInSlab = 0;
+    q->pool.freeNodes = NULL;
+    IsraeliQueuePoolStats emptyStats = { 0 };
+    q->pool.stats = emptyStats;
+    q->array.elements = NULL;
+    q->array.friendsPassed = NULL;
+    q->array.rivalsBlocked = NULL;
+    q->array.tags = NULL;
+    q->array.front = 0;
+    q->array.capacity = 0;
+    q->index.entries = NULL;
+    q->index.mask = 0;
+    q->index.used = 0;
+    q->retired = NULL;
+    q->source = NULL;
+    q->snapshots = NULL;
+    q->nextSnapshot = NULL;
+    q->concurrency = NULL;
+    if (createPairCache(&(q->cache), q->options.pairCacheSize) != ISRAELIQUEUE_SUCCESS){
+        free(q);
+        return NULL;
+    }
+
     int n = 0;
     for (; FriendshipFuncs[n] != NULL; n++);
 
     q->FriendshipFuncs = (FriendshipFunction*)malloc((n+1)*(sizeof(FriendshipFunction)));
     if (q->FriendshipFuncs == NULL){
+        free(q->cache.entries);
         free(q);
         return NULL;
     }
-
     for (int i = 0; i < n; i++){
         q->FriendshipFuncs[i] = FriendshipFuncs[i];
     }
@@ -63,37 +262,138 @@ IsraeliQueue IsraeliQueueCreate(FriendshipFunction* FriendshipFuncs, ComparisonF
     return q;
 }
 
+/**Same as IsraeliQueueCreate, for a queue shared between threads: every function may be called on it
+ * from several threads at once, except IsraeliQueueDestroy, and IsraeliQueueMerge and IsraeliQueueMergeCopy
+ * on an array holding it. The friendship and comparison functions may be called from several threads at once.
+ * Dequeues don't wait for an enqueue to scan the queue, only for it to place its item; enqueues (and any other
+ * change of the queue) wait for each other. Its clones and snapshots are ordinary queues.
+ * A concurrent queue always has the default options: a linked list of malloc'd nodes, with no node pool,
+ * pair cache or hash index, which the two locks of the queue don't protect.
+ * In case of failure, return NULL.*/
+IsraeliQueue IsraeliQueueCreateConcurrent(FriendshipFunction* FriendshipFuncs, ComparisonFunction ComparisonFunc, int friendshipThreshold, int rivalryThreshold){
+    IsraeliQueue q = IsraeliQueueCreate(FriendshipFuncs, ComparisonFunc, friendshipThreshold, rivalryThreshold);
+    if (q == NULL) return NULL;
+    assert(hasDefaultOptions(q));
+
+    israeliConcurrency* concurrency = (israeliConcurrency*)malloc(sizeof(israeliConcurrency));
+    if (concurrency == NULL){
+        IsraeliQueueDestroy(q);
+        return NULL;
+    }
+    pthread_mutex_init(&(concurrency->writeLock), NULL);
+    pthread_mutex_init(&(concurrency->headLock), NULL);
+    concurrency->dequeues = 0;
+    concurrency->scanning = false;
+    concurrency->charges.nodes = NULL;
+    concurrency->charges.count = 0;
+    concurrency->charges.capacity = 0;
+    concurrency->charges.foremostIndex = 0;
+    q->concurrency = concurrency;
+
+    return q;
+}
+
+// appends func to the queue's friendship functions
+IsraeliQueueError addFriendshipFunction(IsraeliQueue q, FriendshipFunction func){
+    int n = 0;
+    for (; q->FriendshipFuncs[n] != NULL; n++);
+
+    FriendshipFunction* newFriendshipFuncs = (FriendshipFunction*)realloc(q->FriendshipFuncs, (n+1 + 1)*(sizeof(FriendshipFunction)));
+    if (!newFriendshipFuncs)  return ISRAELIQUEUE_ALLOC_FAILED;
+    q->FriendshipFuncs = newFriendshipFuncs;
+    q->FriendshipFuncs[n] = func;
+    q->FriendshipFuncs[n+1] = NULL;
+    invalidatePairCache(q);
+
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// appends all the friendship functions of src to those of dest, in order
+IsraeliQueueError copyFriendshipFunctions(IsraeliQueue dest, IsraeliQueue src){
+    int n = 0, added = 0;
+    for (; dest->FriendshipFuncs[n] != NULL; n++);
+    for (; src->FriendshipFuncs[added] != NULL; added++);
+
+    FriendshipFunction* newFriendshipFuncs = (FriendshipFunction*)realloc(dest->FriendshipFuncs, (n+added + 1)*(sizeof(FriendshipFunction)));
+    if (!newFriendshipFuncs)  return ISRAELIQUEUE_ALLOC_FAILED;
+    dest->FriendshipFuncs = newFriendshipFuncs;
+    for (int i = 0; i < added; i++){
+        dest->FriendshipFuncs[n+i] = src->FriendshipFuncs[i];
+    }
+    dest->FriendshipFuncs[n+added] = NULL;
+    invalidatePairCache(dest);
+
+    return ISRAELIQUEUE_SUCCESS;
+}
+
 /**Returns a new queue with the same elements as the parameter. If the parameter is NULL or any error occured during
  * the execution of the function, NULL is returned.*/
 IsraeliQueue IsraeliQueueClone(IsraeliQueue q){
     if (q == NULL) return NULL;
 
+    lockWriter(q);
+    lockHead(q);
+    IsraeliQueue qClone = cloneQueue(q);
+    unlockHead(q);
+    unlockWriter(q);
+
+    return qClone;
+}
+
+// the clone of IsraeliQueueClone, an ordinary queue even for a concurrent one
+IsraeliQueue cloneQueue(IsraeliQueue q){
     FriendshipFunction fArr[] = { NULL };
-    IsraeliQueue qClone = IsraeliQueueCreate(fArr, q->ComparisonFunc, q->friendshipThreshold, q->rivalryThreshold);
+    IsraeliQueue qClone = IsraeliQueueCreateWithOptions(fArr, q->ComparisonFunc, q->friendshipThreshold, q->rivalryThreshold, &(q->options));
     if (qClone == NULL) return NULL; // error
 
-    israeliNode* cur_israeliNode = q->head;
-    while (cur_israeliNode){
-        if (IsraeliQueueEnqueue(qClone, cur_israeliNode->element_ptr) != ISRAELIQUEUE_SUCCESS){
-            IsraeliQueueDestroy(qClone);
-            return NULL;
-        }
-        // copy data
-        qClone->last->friendsPassed = cur_israeliNode->friendsPassed;
-        qClone->last->rivalsBlocked = cur_israeliNode->rivalsBlocked;
-
-        cur_israeliNode = cur_israeliNode->next;
+    // copy the elements with their counters as they are, no need to find their positions again
+    israeliCursor cursor;
+    startCursor(&cursor, q);
+    if (copyFriendshipFunctions(qClone, q) != ISRAELIQUEUE_SUCCESS || copyElements(qClone, &cursor) != ISRAELIQUEUE_SUCCESS){
+        IsraeliQueueDestroy(qClone);
+        return NULL;
     }
 
-    // add functions
-    for (int i = 0; (q->FriendshipFuncs)[i] != NULL; i++){
-        if (IsraeliQueueAddFriendshipMeasure(qClone, (q->FriendshipFuncs)[i]) != ISRAELIQUEUE_SUCCESS){
-            IsraeliQueueDestroy(qClone);
+    return qClone;
+}
+
+/**Returns a copy-on-write snapshot of the queue: a new queue with the same elements and options,
+ * which shares the elements of the parameter instead of copying them. Dequeueing the snapshot, asking
+ * for its size or searching it costs nothing extra; the snapshot copies the elements it still has only
+ * when it is changed in any other way, or right before the parameter is destroyed or changed in any way
+ * other than a dequeue. The parameter keeps the memory of the elements it dequeues while a snapshot
+ * shares them, so that its dequeues never copy anything and never fail.
+ * If the parameter is NULL or any error occured during the execution of the function, NULL is returned.*/
+IsraeliQueue IsraeliQueueSnapshot(IsraeliQueue q){
+    if (q == NULL) return NULL;
+    if (q->concurrency)  return IsraeliQueueClone(q); // sharing would need the queue's locks, a copy doesn't
+
+    // the pair cache is only allocated once the snapshot stops sharing, until then nothing is scored
+    IsraeliQueueOptions options = q->options;
+    options.pairCacheSize = 0;
+    FriendshipFunction fArr[] = { NULL };
+    IsraeliQueue qSnapshot = IsraeliQueueCreateWithOptions(fArr, q->ComparisonFunc, q->friendshipThreshold, q->rivalryThreshold, &options);
+    if (qSnapshot == NULL) return NULL; // error
+    qSnapshot->options = q->options;
+    if (copyFriendshipFunctions(qSnapshot, q) != ISRAELIQUEUE_SUCCESS){
+        IsraeliQueueDestroy(qSnapshot);
+        return NULL;
+    }
+    if (q->size == 0){ // nothing to share
+        if (createPairCache(&(qSnapshot->cache), q->options.pairCacheSize) != ISRAELIQUEUE_SUCCESS){
+            IsraeliQueueDestroy(qSnapshot);
             return NULL;
         }
+        return qSnapshot;
     }
 
-    return qClone;
+    startCursor(&(qSnapshot->shared), q);
+    qSnapshot->source = qSnapshot->shared.owner; // a snapshot of a snapshot shares the same elements
+    qSnapshot->size = q->size;
+    qSnapshot->nextSnapshot = qSnapshot->source->snapshots;
+    qSnapshot->source->snapshots = qSnapshot;
+
+    return qSnapshot;
 }
 
 /**@param IsraeliQueue: an IsraeliQueue created by IsraeliQueueCreate
@@ -102,98 +402,617 @@ IsraeliQueue IsraeliQueueClone(IsraeliQueue q){
  * the parameter.*/
 void IsraeliQueueDestroy(IsraeliQueue q){
     if (!q) return; // already destroyed
-    while (q->head != NULL){
-        IsraeliQueueDequeue(q);
+    removeSnapshot(q);
+    while (q->snapshots){ // they need their elements after this queue is gone
+        IsraeliQueue qSnapshot = q->snapshots;
+        if (ownElements(qSnapshot) != ISRAELIQUEUE_SUCCESS){ // no memory to copy them, the snapshot is left empty
+            removeSnapshot(qSnapshot);
+            qSnapshot->size = 0;
+        }
+    }
+    freeRetired(q); // before the pool they may live in is gone
+    freeElements(q);
+    if (q->concurrency){
+        pthread_mutex_destroy(&(q->concurrency->writeLock));
+        pthread_mutex_destroy(&(q->concurrency->headLock));
+        free(q->concurrency->charges.nodes);
+        free(q->concurrency);
     }
-    if (!(q->FriendshipFuncs))  free(q->FriendshipFuncs);
+    if (q->FriendshipFuncs)  free(q->FriendshipFuncs);
+    free(q->cache.entries);
     free(q);
 }
 
-bool areFriends(IsraeliQueue q, void* item1, void* item2){
-    if (!q || !(q->FriendshipFuncs) || !item1 || !item2) return false; // bad parameters
+// frees the elements the queue stores (not the elements themselves) and its index, leaving it empty
+void freeElements(IsraeliQueue q){
+    if (isArrayStorage(q)){
+        free(q->array.elements);
+        free(q->array.friendsPassed);
+        free(q->array.rivalsBlocked);
+        q->array.elements = NULL;
+        q->array.friendsPassed = NULL;
+        q->array.rivalsBlocked = NULL;
+        q->array.front = 0;
+        q->array.capacity = 0;
+    }
+    else if (q->options.nodePoolSlabSize > 0){ // nodes live in the slabs, no need to free them one by one
+        destroyNodePool(&(q->pool));
+    }
+    else{
+        israeliNode* tmp;
+        while (q->head != NULL){
+            tmp = q->head;
+            q->head = tmp->next;
+            free(tmp);
+        }
+    }
+    q->head = NULL;
+    q->last = NULL;
+    q->size = 0;
+    free(q->index.entries);
+    q->index.entries = NULL;
+    q->index.mask = 0;
+    q->index.used = 0;
+}
+
+// SNAPSHOTS
+// positions the cursor on the first element of q
+void startCursor(israeliCursor* cursor, IsraeliQueue q){
+    if (q->source){
+        *cursor = q->shared;
+        cursor->remaining = q->size;
+        return;
+    }
+    cursor->owner = q;
+    cursor->node = q->head;
+    cursor->index = q->array.front;
+    cursor->remaining = q->size;
+}
+
+// returns the next element and its counters (if the pointers aren't NULL), or NULL after the last one
+void* cursorNext(israeliCursor* cursor, int* friendsPassed_ptr, int* rivalsBlocked_ptr){
+    if (cursor->remaining == 0)  return NULL;
+    cursor->remaining--;
 
-    for (int i = 0; q->FriendshipFuncs[i] != NULL; i++){
-        if (q->FriendshipFuncs[i](item1, item2) > q->friendshipThreshold){
+    if (isArrayStorage(cursor->owner)){
+        israeliArray* arr = &(cursor->owner->array);
+        if (friendsPassed_ptr)  *friendsPassed_ptr = arr->friendsPassed[cursor->index];
+        if (rivalsBlocked_ptr)  *rivalsBlocked_ptr = arr->rivalsBlocked[cursor->index];
+        return arr->elements[cursor->index++];
+    }
+    israeliNode* node = cursor->node;
+    cursor->node = node->next;
+    if (friendsPassed_ptr)  *friendsPassed_ptr = node->friendsPassed;
+    if (rivalsBlocked_ptr)  *rivalsBlocked_ptr = node->rivalsBlocked;
+    return node->element_ptr;
+}
+
+// appends the rest of the cursor's elements to the empty queue dest with their counters, without scoring anything
+// dest must have the same storage as the queue the cursor reads
+IsraeliQueueError copyElements(IsraeliQueue dest, israeliCursor* cursor){
+    int count = cursor->remaining;
+    void* element; int friendsPassed; int rivalsBlocked;
+    if (isArrayStorage(dest)){
+        if (growArray(dest, count) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+        dest->array.front = 0;
+        if (count > 0){
+            israeliArray* arr = &(cursor->owner->array);
+            memcpy(dest->array.elements, arr->elements + cursor->index, count * sizeof(void*));
+            memcpy(dest->array.friendsPassed, arr->friendsPassed + cursor->index, count * sizeof(int));
+            memcpy(dest->array.rivalsBlocked, arr->rivalsBlocked + cursor->index, count * sizeof(int));
+        }
+        dest->size = count;
+        for (int i = 0; i < count; i++){
+            if (addToIndex(dest, dest->array.elements[i]) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+        }
+        return ISRAELIQUEUE_SUCCESS;
+    }
+
+    israeliNode* node;
+    while ((element = cursorNext(cursor, &friendsPassed, &rivalsBlocked)) != NULL){
+        node = allocNode(dest);
+        if (!node)  return ISRAELIQUEUE_ALLOC_FAILED;
+        node->element_ptr = element;
+        node->friendsPassed = friendsPassed;
+        node->rivalsBlocked = rivalsBlocked;
+        insertIsraeliNode(dest, dest->last, node, false); // placed last, nobody's counters change
+        if (addToIndex(dest, element) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+    }
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// stops q from sharing the elements of its source, if it still does
+// the nodes the source dequeued meanwhile are freed once no snapshot shares its elements anymore
+void removeSnapshot(IsraeliQueue q){
+    if (!(q->source))  return;
+    IsraeliQueue* link = &(q->source->snapshots);
+    while (*link != q){
+        link = &((*link)->nextSnapshot);
+    }
+    *link = q->nextSnapshot;
+    if (!(q->source->snapshots))  freeRetired(q->source);
+    q->nextSnapshot = NULL;
+    q->source = NULL;
+}
+
+// the copy of copy-on-write: gives a snapshot its own copy of the elements it still shares
+// on failure the snapshot keeps sharing them, unchanged
+IsraeliQueueError ownElements(IsraeliQueue q){
+    if (!(q->source))  return ISRAELIQUEUE_SUCCESS;
+    if (createPairCache(&(q->cache), q->options.pairCacheSize) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+
+    israeliCursor cursor;
+    startCursor(&cursor, q);
+    int size = q->size;
+    q->size = 0;
+    if (copyElements(q, &cursor) != ISRAELIQUEUE_SUCCESS){
+        freeElements(q);
+        free(q->cache.entries);
+        q->cache.entries = NULL;
+        q->size = size;
+        return ISRAELIQUEUE_ALLOC_FAILED;
+    }
+    removeSnapshot(q);
+
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// called before changing the elements of q in any way: a snapshot copies the elements it shares,
+// and the snapshots sharing q's elements copy them before they change
+IsraeliQueueError prepareWrite(IsraeliQueue q){
+    if (ownElements(q) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+    while (q->snapshots){
+        if (ownElements(q->snapshots) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+    }
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// NODE POOL
+// returns a node for the queue, from its pool if it has one, NULL on allocation failure
+israeliNode* allocNode(IsraeliQueue q){
+    if (!q) return NULL; // bad parameter
+    if (q->options.nodePoolSlabSize <= 0)  return (israeliNode*)malloc(sizeof(israeliNode));
+
+    israeliNodePool* pool = &(q->pool);
+    israeliNode* node;
+    if (pool->freeNodes){ // recycle a dequeued node
+        node = pool->freeNodes;
+        pool->freeNodes = node->next;
+        pool->stats.reused++;
+    }
+    else{
+        if (!(pool->slabs) || pool->usedInSlab == q->options.nodePoolSlabSize){ // newest slab is full
+            israeliSlab* slab = (israeliSlab*)malloc(sizeof(israeliSlab) + q->options.nodePoolSlabSize * sizeof(israeliNode));
+            if (!slab)  return NULL;
+            slab->next = pool->slabs;
+            pool->slabs = slab;
+            pool->usedInSlab = 0;
+            pool->stats.slabs++;
+            pool->stats.capacity += q->options.nodePoolSlabSize;
+        }
+        node = &(pool->slabs->nodes[pool->usedInSlab++]);
+    }
+
+    pool->stats.allocations++;
+    pool->stats.inUse++;
+    if (pool->stats.inUse > pool->stats.peakInUse){
+        pool->stats.peakInUse = pool->stats.inUse;
+    }
+    return node;
+}
+
+// gives a node back to the queue's pool, or frees it if the queue has no pool
+void freeNode(IsraeliQueue q, israeliNode* node){
+    if (!q || !node) return; // bad parameters
+    if (q->options.nodePoolSlabSize <= 0){
+        free(node);
+        return;
+    }
+
+    node->next = q->pool.freeNodes;
+    q->pool.freeNodes = node;
+    q->pool.stats.inUse--;
+}
+
+// frees every slab of the pool, including the nodes still in use, leaving an empty pool that can grow again
+// the statistics of what the slabs held go back to 0, the peak and the counts of allocations stay
+void destroyNodePool(israeliNodePool* pool){
+    if (!pool) return; // bad parameter
+    israeliSlab* slab = pool->slabs;
+    israeliSlab* tmp;
+    while (slab){
+        tmp = slab->next;
+        free(slab);
+        slab = tmp;
+    }
+    pool->slabs = NULL;
+    pool->usedInSlab = 0;
+    pool->freeNodes = NULL;
+    pool->stats.slabs = 0;
+    pool->stats.capacity = 0;
+    pool->stats.inUse = 0;
+}
+
+/**@param stats: where to write the node pool usage of the queue
+ *
+ * Fills stats with the node pool usage of the queue. A queue created without a node pool reports
+ * all zeros. If either parameter is NULL, ISRAELIQUEUE_BAD_PARAM is returned.*/
+IsraeliQueueError IsraeliQueueGetPoolStats(IsraeliQueue q, IsraeliQueuePoolStats* stats){
+    if (!q || !stats)  return ISRAELIQUEUE_BAD_PARAM;
+    *stats = q->pool.stats;
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// PAIR CACHE
+// allocates an empty cache of at least size entries (rounded up to a power of two), size 0 means no cache
+IsraeliQueueError createPairCache(israeliPairCache* cache, int size){
+    IsraeliQueueCacheStats emptyStats = { 0, 0 };
+    cache->stats = emptyStats;
+    cache->generation = 1;
+    cache->entries = NULL;
+    cache->mask = 0;
+    if (size <= 0)  return ISRAELIQUEUE_SUCCESS;
+
+    size_t n = 1;
+    while (n < (size_t)size){
+        n *= 2;
+    }
+    cache->entries = (israeliCacheEntry*)calloc(n, sizeof(israeliCacheEntry));
+    if (!(cache->entries))  return ISRAELIQUEUE_ALLOC_FAILED;
+    cache->mask = n - 1;
+
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// forgets every cached verdict, called whenever the friendship functions or thresholds change
+void invalidatePairCache(IsraeliQueue q){
+    if (!(q->cache.entries))  return;
+    q->cache.generation++;
+    if (q->cache.generation == 0){ // wrapped around, old entries could look current again
+        memset(q->cache.entries, 0, (q->cache.mask + 1) * sizeof(israeliCacheEntry));
+        q->cache.generation = 1;
+    }
+}
+
+/**@param stats: where to write the pair cache usage of the queue
+ *
+ * Fills stats with the hit and miss counts of the queue's pair cache. A queue created without a pair
+ * cache reports all zeros. If either parameter is NULL, ISRAELIQUEUE_BAD_PARAM is returned.*/
+IsraeliQueueError IsraeliQueueGetCacheStats(IsraeliQueue q, IsraeliQueueCacheStats* stats){
+    if (!q || !stats)  return ISRAELIQUEUE_BAD_PARAM;
+    *stats = q->cache.stats;
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// MEMBERSHIP INDEX
+// the home slot of a hash, mixed first since user hashes (e.g. IDs) are often far from uniform
+size_t indexSlot(israeliMembershipIndex* index, unsigned long hash){
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDul;
+    hash ^= hash >> 33;
+    return (size_t)hash & index->mask;
+}
+
+// doubles the number of slots (or allocates the first ones) and places every entry again
+IsraeliQueueError growIndex(israeliMembershipIndex* index){
+    size_t slots = index->entries ? (index->mask + 1) * 2 : 16;
+    israeliIndexEntry* entries = (israeliIndexEntry*)calloc(slots, sizeof(israeliIndexEntry));
+    if (!entries)  return ISRAELIQUEUE_ALLOC_FAILED;
+
+    israeliIndexEntry* oldEntries = index->entries;
+    size_t oldSlots = oldEntries ? index->mask + 1 : 0;
+    index->entries = entries;
+    index->mask = slots - 1;
+    for (size_t i = 0; i < oldSlots; i++){
+        if (oldEntries[i].count == 0)  continue;
+        size_t slot = indexSlot(index, oldEntries[i].hash);
+        while (entries[slot].count != 0){
+            slot = (slot + 1) & index->mask;
+        }
+        entries[slot] = oldEntries[i];
+    }
+    free(oldEntries);
+
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// records one more occurrence of element in the queue
+IsraeliQueueError addToIndex(IsraeliQueue q, void* element){
+    if (!(q->options.hashFunc))  return ISRAELIQUEUE_SUCCESS;
+    israeliMembershipIndex* index = &(q->index);
+    if (!(index->entries) || (index->used + 1) * 2 > index->mask + 1){ // keep at most half of the slots full
+        if (growIndex(index) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+    }
+
+    unsigned long hash = q->options.hashFunc(element);
+    size_t slot = indexSlot(index, hash);
+    while (index->entries[slot].count != 0){
+        if (index->entries[slot].element == element){
+            index->entries[slot].count++;
+            return ISRAELIQUEUE_SUCCESS;
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    index->entries[slot].element = element;
+    index->entries[slot].hash = hash;
+    index->entries[slot].count = 1;
+    index->used++;
+
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// forgets one occurrence of element, emptying its slot when it was the last one
+void removeFromIndex(IsraeliQueue q, void* element){
+    if (!(q->options.hashFunc) || !(q->index.entries))  return;
+    israeliMembershipIndex* index = &(q->index);
+
+    size_t slot = indexSlot(index, q->options.hashFunc(element));
+    while (index->entries[slot].count != 0 && index->entries[slot].element != element){
+        slot = (slot + 1) & index->mask;
+    }
+    if (index->entries[slot].count == 0)  return; // not in the index
+    if (--(index->entries[slot].count) > 0)  return;
+    index->used--;
+
+    // close the gap: move back every following entry of the run that may no longer be reachable
+    size_t gap = slot;
+    size_t cur = (slot + 1) & index->mask;
+    size_t home;
+    while (index->entries[cur].count != 0){
+        home = indexSlot(index, index->entries[cur].hash);
+        if (((cur - home) & index->mask) >= ((cur - gap) & index->mask)){ // its home is at or before the gap
+            index->entries[gap] = index->entries[cur];
+            index->entries[cur].count = 0;
+            gap = cur;
+        }
+        cur = (cur + 1) & index->mask;
+    }
+}
+
+// looks for an element equal to the given one only among the elements with the same hash
+bool indexContains(IsraeliQueue q, void* element){
+    israeliMembershipIndex* index = &(q->index);
+    if (!(index->entries))  return false;
+
+    unsigned long hash = q->options.hashFunc(element);
+    int same = q->ComparisonFunc(element, element); // defining SAME
+    size_t slot = indexSlot(index, hash);
+    while (index->entries[slot].count != 0){
+        if (index->entries[slot].hash == hash && q->ComparisonFunc(index->entries[slot].element, element) == same){
             return true;
         }
+        slot = (slot + 1) & index->mask;
     }
     return false;
 }
 
-bool areRivals(IsraeliQueue q, void* item1, void* item2){
-    if (!q || !(q->FriendshipFuncs) || !item1 || !item2) return false; // bad parameters
-    
-    if (areFriends(q, item1, item2)){
-        return false;
+// the verdict of the pair, from the pair cache when the queue has one
+israeliVerdict scorePair(IsraeliQueue q, void* item1, void* item2){
+    if (!q || !(q->cache.entries))  return evaluatePair(q, item1, item2);
+
+    uintptr_t key = (uintptr_t)item1 * 0x9E3779B1u ^ ((uintptr_t)item2 + ((uintptr_t)item2 >> 7)) * 0x85EBCA77u;
+    israeliCacheEntry* entry = &(q->cache.entries[(key ^ (key >> 16)) & q->cache.mask]);
+    if (entry->generation == q->cache.generation && entry->item1 == item1 && entry->item2 == item2){
+        q->cache.stats.hits++;
+        return entry->verdict;
     }
 
-    int friendshipSum = 0; int i = 0;
-    for (; q->FriendshipFuncs[i] != NULL; i++){
-        friendshipSum += q->FriendshipFuncs[i](item1, item2);
+    q->cache.stats.misses++;
+    entry->item1 = item1;
+    entry->item2 = item2;
+    entry->generation = q->cache.generation;
+    entry->verdict = evaluatePair(q, item1, item2);
+    return entry->verdict;
+}
+
+// calls every friendship function at most once for the pair, and decides both friendship and rivalry from those scores
+// friends: any score above the friendship threshold
+// rivals: not friends, and the average score is below the rivalry threshold
+israeliVerdict evaluatePair(IsraeliQueue q, void* item1, void* item2){
+    israeliVerdict verdict = { false, false };
+    if (!q || !(q->FriendshipFuncs) || !item1 || !item2) return verdict; // bad parameters
+
+    int friendshipSum = 0; int n = 0;
+    for (int i = 0; q->FriendshipFuncs[i] != NULL; i++){
+        int score = q->FriendshipFuncs[i](item1, item2);
+        if (score > q->friendshipThreshold){
+            verdict.friends = true; // friends can't be rivals, the rest of the scores are irrelevant
+            return verdict;
+        }
+        friendshipSum += score;
+        n++;
     }
-    if (i == 0)  return false; // no friendship functions
+    if (n == 0)  return verdict; // no friendship functions
 
-    if (friendshipSum/i < q->rivalryThreshold){
-        return true;
+    if (friendshipSum/n < q->rivalryThreshold){
+        verdict.rivals = true;
     }
-    return false;
+    return verdict;
 }
 
-israeliNode* findForemostPos(IsraeliQueue q, void* item){
-    if (!q || !item) return NULL; // bad parameters
+// returns the node the item should be placed after (q->last if it can't skip), or NULL if the queue is empty
+// *lastIsFriend_ptr is set to whether the last node is a friend of the item, so the caller doesn't score it again
+israeliNode* findForemostPos(IsraeliQueue q, void* item, bool* lastIsFriend_ptr){
+    return scanForemostPos(q, item, q->head, q->last, NULL, lastIsFriend_ptr);
+}
 
-    israeliNode* friend = q->last;
-    israeliNode* cur_israeliNode = q->head;
+// findForemostPos over the nodes from head to last, which may be a past state of the queue
+// the rivals found are charged right away, or only added to charges if it isn't NULL
+israeliNode* scanForemostPos(IsraeliQueue q, void* item, israeliNode* head, israeliNode* last, israeliCharges* charges,
+                             bool* lastIsFriend_ptr){
+    if (!q || !item || !lastIsFriend_ptr) return NULL; // bad parameters
+
+    *lastIsFriend_ptr = false;
+    israeliNode* friend = last;
+    israeliNode* cur_israeliNode = head;
+    israeliVerdict verdict;
+    int index = -1, friendIndex = -1;
     while (cur_israeliNode != NULL){
-        if (friend == q->last && areFriends(q, cur_israeliNode->element_ptr, item) && cur_israeliNode->friendsPassed < FRIEND_QUOTA){
+        index++;
+        if (cur_israeliNode->rivalsBlocked >= RIVAL_QUOTA && cur_israeliNode != last &&
+            (friend != last || cur_israeliNode->friendsPassed >= FRIEND_QUOTA)){
+            // its verdict can't change the result: it has no rival quota left and can't become the friend
+            cur_israeliNode = cur_israeliNode->next;
+            continue;
+        }
+        verdict = scorePair(q, cur_israeliNode->element_ptr, item);
+        if (friend == last && verdict.friends && cur_israeliNode->friendsPassed < FRIEND_QUOTA){
             friend = cur_israeliNode;
+            friendIndex = index;
+        }
+        if (verdict.rivals && cur_israeliNode->rivalsBlocked < RIVAL_QUOTA){
+            if (charges)  charges->nodes[charges->count++] = cur_israeliNode;
+            else          cur_israeliNode->rivalsBlocked++;
+            friend = last;
         }
-        if (areRivals(q, cur_israeliNode->element_ptr, item) && cur_israeliNode->rivalsBlocked < RIVAL_QUOTA){
-            cur_israeliNode->rivalsBlocked++;
-            friend = q->last;
+        if (cur_israeliNode == last){
+            *lastIsFriend_ptr = verdict.friends;
+            break; // nodes placed after the scan started aren't part of it
         }
 
         cur_israeliNode = cur_israeliNode->next;
     }
 
+    if (charges)  charges->foremostIndex = friend == last ? index : friendIndex;
     return friend;
 }
 
-israeliNode* insertItem(IsraeliQueue q, israeliNode* foremostPos, void* item){
-    if (!q || !foremostPos || !item)  return NULL; // bad parameters
+// foremostPos may only be NULL when the queue is empty
+israeliNode* insertItem(IsraeliQueue q, israeliNode* foremostPos, void* item, bool lastIsFriend){
+    if (!q || !item || (!foremostPos && q->head))  return NULL; // bad parameters
 
     // CREATE NODE
-    israeliNode* item_israeliNode = (israeliNode*)malloc(sizeof(israeliNode));
+    israeliNode* item_israeliNode = allocNode(q);
     if (item_israeliNode == NULL)  return NULL;
     item_israeliNode->element_ptr = item;
-    item_israeliNode->next = NULL;
-    item_israeliNode->previous = NULL;
     item_israeliNode->friendsPassed = 0;
     item_israeliNode->rivalsBlocked = 0;
 
     // PLACE NODE
-    if (q->head == NULL){ // empty queue
-        q->head = item_israeliNode;
-        q->last = item_israeliNode;
-    } 
-    else if (foremostPos == q->last){ // no possible skip, place last
-        q->last->next = item_israeliNode;
-        item_israeliNode->previous = q->last;
-        q->last = item_israeliNode;
-        if (areFriends(q, foremostPos->element_ptr, item_israeliNode->element_ptr)){
-            foremostPos->friendsPassed++;
+    insertIsraeliNode(q, foremostPos, item_israeliNode, lastIsFriend);
+
+    return item_israeliNode;
+}
+
+// ARRAY STORAGE
+bool isArrayStorage(IsraeliQueue q){
+    return q->options.storage == ISRAELIQUEUE_STORAGE_ARRAY;
+}
+
+// the array counterpart of findForemostPos, positions are counted from the front of the queue
+// returns the index the item should be placed after (size-1 if it can't skip), or -1 if the queue is empty
+int findForemostIndex(IsraeliQueue q, void* item, bool* lastIsFriend_ptr){
+    if (!q || !item || !lastIsFriend_ptr) return -1; // bad parameters
+
+    *lastIsFriend_ptr = false;
+    int last = q->size - 1;
+    int friend = last;
+    void** elements = q->array.elements + q->array.front;
+    int* friendsPassed = q->array.friendsPassed + q->array.front;
+    int* rivalsBlocked = q->array.rivalsBlocked + q->array.front;
+    israeliVerdict verdict = { false, false }; // the last element is never skipped, so it's always scored
+    for (int i = 0; i < q->size; i++){
+        if (rivalsBlocked[i] >= RIVAL_QUOTA && i != last && (friend != last || friendsPassed[i] >= FRIEND_QUOTA)){
+            continue; // its verdict can't change the result, same as in findForemostPos
+        }
+        verdict = scorePair(q, elements[i], item);
+        if (friend == last && verdict.friends && friendsPassed[i] < FRIEND_QUOTA){
+            friend = i;
+        }
+        if (verdict.rivals && rivalsBlocked[i] < RIVAL_QUOTA){
+            rivalsBlocked[i]++;
+            friend = last;
         }
     }
-    else{ // can skip
-        item_israeliNode->next = foremostPos->next;
-        item_israeliNode->previous = foremostPos;
+    if (q->size > 0){
+        *lastIsFriend_ptr = verdict.friends;
+    }
 
-        foremostPos->next->previous = item_israeliNode;
-        foremostPos->next = item_israeliNode;
-        foremostPos->friendsPassed++;
+    return friend;
+}
+
+// moves count entries of every array (absolute indices), the ranges may overlap
+void moveArrayBlock(israeliArray* arr, int to, int from, int count){
+    if (count <= 0 || to == from)  return;
+    memmove(arr->elements + to, arr->elements + from, count * sizeof(void*));
+    memmove(arr->friendsPassed + to, arr->friendsPassed + from, count * sizeof(int));
+    memmove(arr->rivalsBlocked + to, arr->rivalsBlocked + from, count * sizeof(int));
+    if (arr->tags){
+        memmove(arr->tags + to, arr->tags + from, count * sizeof(int));
     }
+}
 
-    return item_israeliNode;
+// reallocates the arrays to hold at least minCapacity entries, keeping front in place
+IsraeliQueueError growArray(IsraeliQueue q, int minCapacity){
+    israeliArray* arr = &(q->array);
+    if (minCapacity <= arr->capacity)  return ISRAELIQUEUE_SUCCESS;
+
+    int capacity = arr->capacity > 8 ? arr->capacity : 8;
+    while (capacity < minCapacity){
+        capacity *= 2;
+    }
+    // each array is kept as soon as it is reallocated, capacity is only updated once all of them succeeded
+    void** elements = (void**)realloc(arr->elements, capacity * sizeof(void*));
+    if (!elements)  return ISRAELIQUEUE_ALLOC_FAILED;
+    arr->elements = elements;
+    int* friendsPassed = (int*)realloc(arr->friendsPassed, capacity * sizeof(int));
+    if (!friendsPassed)  return ISRAELIQUEUE_ALLOC_FAILED;
+    arr->friendsPassed = friendsPassed;
+    int* rivalsBlocked = (int*)realloc(arr->rivalsBlocked, capacity * sizeof(int));
+    if (!rivalsBlocked)  return ISRAELIQUEUE_ALLOC_FAILED;
+    arr->rivalsBlocked = rivalsBlocked;
+    if (arr->tags){
+        int* tags = (int*)realloc(arr->tags, capacity * sizeof(int));
+        if (!tags)  return ISRAELIQUEUE_ALLOC_FAILED;
+        arr->tags = tags;
+    }
+
+    arr->capacity = capacity;
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// makes room for a new entry at position at (counted from the front), moving whichever side is shorter
+// the new slot's contents are left for the caller to fill, size is not updated
+IsraeliQueueError openArraySlot(IsraeliQueue q, int at){
+    israeliArray* arr = &(q->array);
+    if (at < q->size - at && arr->front > 0){ // shift the elements before the slot one step towards the front
+        arr->front--;
+        moveArrayBlock(arr, arr->front, arr->front + 1, at);
+        return ISRAELIQUEUE_SUCCESS;
+    }
+
+    if (arr->front + q->size == arr->capacity){ // no room after the last element
+        if (q->size + 1 <= arr->capacity / 2){ // mostly empty, reuse the room left at the front by dequeues
+            moveArrayBlock(arr, 0, arr->front, q->size);
+            arr->front = 0;
+        }
+        else if (growArray(q, arr->front + q->size + 1) != ISRAELIQUEUE_SUCCESS){
+            return ISRAELIQUEUE_ALLOC_FAILED;
+        }
+    }
+    moveArrayBlock(arr, arr->front + at + 1, arr->front + at, q->size - at);
+    return ISRAELIQUEUE_SUCCESS;
+}
+
+// the array counterpart of insertItem and insertIsraeliNode: places item after foremostIndex (-1 on an empty queue)
+IsraeliQueueError placeInArray(IsraeliQueue q, int foremostIndex, void* item, int friendsPassed, int rivalsBlocked, bool lastIsFriend){
+    if (!q || !item || foremostIndex < -1 || foremostIndex >= q->size)  return ISRAELIQUEUE_BAD_PARAM;
+    if (foremostIndex == -1 && q->size > 0)  return ISRAELIQUEUE_BAD_PARAM;
+
+    int at = foremostIndex + 1;
+    if (openArraySlot(q, at) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+    israeliArray* arr = &(q->array);
+    arr->elements[arr->front + at] = item;
+    arr->friendsPassed[arr->front + at] = friendsPassed;
+    arr->rivalsBlocked[arr->front + at] = rivalsBlocked;
+
+    if (foremostIndex != -1 && (foremostIndex != q->size - 1 || lastIsFriend)){
+        // skipped after a friend, or placed last right behind a friend
+        arr->friendsPassed[arr->front + foremostIndex]++;
+    }
+    q->size++;
+
+    return ISRAELIQUEUE_SUCCESS;
 }
 
 /**@param IsraeliQueue: an IsraeliQueue in which to insert the item.
@@ -202,15 +1021,214 @@ israeliNode* insertItem(IsraeliQueue q, israeliNode* foremostPos, void* item){
  * Places the item in the foremost position accessible to it.*/
 IsraeliQueueError IsraeliQueueEnqueue(IsraeliQueue q, void* item){
     if (!q || !item)  return ISRAELIQUEUE_BAD_PARAM;
+    if (q->concurrency){
+        lockWriter(q);
+        IsraeliQueueError result = enqueueConcurrent(q, item);
+        unlockWriter(q);
+        return result;
+    }
+    if (prepareWrite(q) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+    return enqueueItem(q, item);
+}
 
-    israeliNode* foremostPos = findForemostPos(q, item);
-    if (!foremostPos)  return ISRAELI_QUEUE_ERROR;
-    if (insertItem(q, foremostPos, item) == NULL){
-        return ISRAELIQUEUE_ALLOC_FAILED;
+// places a single item in a queue ready to be written
+IsraeliQueueError enqueueItem(IsraeliQueue q, void* item){
+    if (addToIndex(q, item) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+
+    IsraeliQueueError result = ISRAELIQUEUE_SUCCESS;
+    bool lastIsFriend;
+    if (isArrayStorage(q)){
+        int foremostIndex = findForemostIndex(q, item, &lastIsFriend);
+        result = placeInArray(q, foremostIndex, item, 0, 0, lastIsFriend);
+    }
+    else{
+        israeliNode* foremostPos = findForemostPos(q, item, &lastIsFriend);
+        if (!foremostPos && q->head)  result = ISRAELI_QUEUE_ERROR;
+        else if (insertItem(q, foremostPos, item, lastIsFriend) == NULL)  result = ISRAELIQUEUE_ALLOC_FAILED;
+    }
+
+    if (result != ISRAELIQUEUE_SUCCESS)  removeFromIndex(q, item); // the item didn't make it into the queue
+    return result;
+}
+
+// CONCURRENT QUEUE
+// the locks of a concurrent queue, doing nothing for any other queue
+void lockWriter(IsraeliQueue q){
+    if (q->concurrency)  pthread_mutex_lock(&(q->concurrency->writeLock));
+}
+
+void unlockWriter(IsraeliQueue q){
+    if (q->concurrency)  pthread_mutex_unlock(&(q->concurrency->writeLock));
+}
+
+void lockHead(IsraeliQueue q){
+    if (q->concurrency)  pthread_mutex_lock(&(q->concurrency->headLock));
+}
+
+void unlockHead(IsraeliQueue q){
+    if (q->concurrency)  pthread_mutex_unlock(&(q->concurrency->headLock));
+}
+
+// frees the retired nodes, once no scan or snapshot can reach them anymore
+void freeRetired(IsraeliQueue q){
+    israeliNode* node = q->retired;
+    israeliNode* previous;
+    q->retired = NULL;
+    while (node){
+        previous = node->previous;
+        freeNode(q, node);
+        node = previous;
+    }
+}
+
+// whether the queue is a plain list, the only kind of queue that can be concurrent
+bool hasDefaultOptions(IsraeliQueue q){
+    return q->options.storage == ISRAELIQUEUE_STORAGE_LIST && q->options.nodePoolSlabSize <= 0 &&
+           q->options.pairCacheSize <= 0 && q->options.hashFunc == NULL;
+}
+
+// enqueues an item in a concurrent queue, with writeLock held
+// the queue is scanned without headLock, so dequeues go on meanwhile: only the writer changes the links and
+// counters the scan reads, and dequeued nodes are retired instead of freed until it is done. headLock is only
+// taken to start a scan, then to check it and place the item. The rivals it finds are charged once the item
+// is placed, and if its node was dequeued during it, what is left of the queue is scanned again the same way;
+// every such scan means a dequeue, and nothing else is enqueued meanwhile, so the queue runs out of nodes first
+IsraeliQueueError enqueueConcurrent(IsraeliQueue q, void* item){
+    israeliConcurrency* concurrency = q->concurrency;
+    assert(hasDefaultOptions(q));
+    israeliNode* node = allocNode(q);
+    if (node == NULL)  return ISRAELIQUEUE_ALLOC_FAILED;
+    node->element_ptr = item;
+    node->friendsPassed = 0;
+    node->rivalsBlocked = 0;
+
+    israeliCharges* charges = &(concurrency->charges);
+    israeliNode* foremostPos = NULL;
+    bool lastIsFriend = false;
+    israeliNode* head; israeliNode* last;
+    int size; unsigned long dequeues;
+    pthread_mutex_lock(&(concurrency->headLock));
+    while (q->head){
+        head = q->head;
+        last = q->last;
+        size = q->size;
+        dequeues = concurrency->dequeues;
+        concurrency->scanning = true;
+        pthread_mutex_unlock(&(concurrency->headLock));
+
+        if (size > charges->capacity){ // the scan charges every node at most once
+            israeliNode** nodes = (israeliNode**)realloc(charges->nodes, size * sizeof(israeliNode*));
+            if (!nodes){
+                pthread_mutex_lock(&(concurrency->headLock));
+                concurrency->scanning = false;
+                freeRetired(q);
+                pthread_mutex_unlock(&(concurrency->headLock));
+                freeNode(q, node);
+                return ISRAELIQUEUE_ALLOC_FAILED;
+            }
+            charges->nodes = nodes;
+            charges->capacity = size;
+        }
+        charges->count = 0;
+        foremostPos = scanForemostPos(q, item, head, last, charges, &lastIsFriend);
+
+        pthread_mutex_lock(&(concurrency->headLock));
+        concurrency->scanning = false;
+        if (concurrency->dequeues - dequeues <= (unsigned long)(charges->foremostIndex)){
+            // only nodes before foremostPos left, the scan is still valid; charging retired nodes is harmless
+            for (int i = 0; i < charges->count; i++){
+                charges->nodes[i]->rivalsBlocked++;
+            }
+            break;
+        }
+        freeRetired(q); // the next scan starts after them
+        foremostPos = NULL;
+        lastIsFriend = false;
     }
+    insertIsraeliNode(q, foremostPos, node, lastIsFriend);
+    freeRetired(q);
+    pthread_mutex_unlock(&(concurrency->headLock));
+
     return ISRAELIQUEUE_SUCCESS;
 }
 
+// dequeues from a concurrent queue, only waiting for an enqueue to place its item, not for its scan
+void* dequeueConcurrent(IsraeliQueue q){
+    israeliConcurrency* concurrency = q->concurrency;
+    assert(hasDefaultOptions(q));
+    pthread_mutex_lock(&(concurrency->headLock));
+    israeliNode* node = q->head;
+    if (node == NULL){
+        pthread_mutex_unlock(&(concurrency->headLock));
+        return NULL;
+    }
+    q->head = node->next;
+    if (q->head != NULL)  q->head->previous = NULL;
+    else                  q->last = NULL;
+    q->size--;
+    concurrency->dequeues++;
+    void* element = node->element_ptr;
+    if (concurrency->scanning){ // the scan may still be reading it
+        node->previous = q->retired;
+        q->retired = node;
+    }
+    else{
+        freeNode(q, node);
+    }
+    pthread_mutex_unlock(&(concurrency->headLock));
+
+    return element;
+}
+
+// BATCH ENQUEUE
+/**@param IsraeliQueue: an IsraeliQueue in which to insert the items.
+ * @param items: an array of n items to enqueue
+ * @param n: the number of items
+ *
+ * Places the items one after the other, each in the foremost position accessible to it, exactly as
+ * n calls to IsraeliQueueEnqueue would. A queue without friendship functions appends them all without
+ * scanning it. If any item is NULL nothing is enqueued and ISRAELIQUEUE_BAD_PARAM is returned; on any
+ * other error the items before the failing one stay enqueued.*/
+IsraeliQueueError IsraeliQueueEnqueueBatch(IsraeliQueue q, void** items, int n){
+    if (!q || n < 0 || (!items && n > 0))  return ISRAELIQUEUE_BAD_PARAM;
+    for (int i = 0; i < n; i++){
+        if (!items[i])  return ISRAELIQUEUE_BAD_PARAM;
+    }
+    IsraeliQueueError result;
+    if (q->concurrency){ // the enqueues of other threads wait for the whole batch
+        result = ISRAELIQUEUE_SUCCESS;
+        lockWriter(q);
+        for (int i = 0; i < n && result == ISRAELIQUEUE_SUCCESS; i++){
+            result = enqueueConcurrent(q, items[i]);
+        }
+        unlockWriter(q);
+        return result;
+    }
+    if (n > 0 && prepareWrite(q) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+
+    if (q->FriendshipFuncs[0] == NULL){ // no friends and no rivals, every item simply goes last
+        bool lastIsFriend = false;
+        for (int i = 0; i < n; i++){
+            if (addToIndex(q, items[i]) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+            if (isArrayStorage(q))  result = placeInArray(q, q->size - 1, items[i], 0, 0, lastIsFriend);
+            else                    result = insertItem(q, q->last, items[i], lastIsFriend) ? ISRAELIQUEUE_SUCCESS : ISRAELIQUEUE_ALLOC_FAILED;
+            if (result != ISRAELIQUEUE_SUCCESS){
+                removeFromIndex(q, items[i]);
+                return result;
+            }
+        }
+        return ISRAELIQUEUE_SUCCESS;
+    }
+
+    // every item needs the verdicts of the elements ahead of it, the items placed before it included, so
+    // there is nothing to share between the scans
+    result = ISRAELIQUEUE_SUCCESS;
+    for (int i = 0; i < n && result == ISRAELIQUEUE_SUCCESS; i++){
+        result = enqueueItem(q, items[i]);
+    }
+    return result;
+}
+
 /**@param IsraeliQueue: an IsraeliQueue to which the function is to be added
  * @param FriendshipFunction: a FriendshipFunction to be recognized by the IsraeliQueue
  * going forward.
@@ -218,31 +1236,20 @@ IsraeliQueueError IsraeliQueueEnqueue(IsraeliQueue q, void* item){
  * Makes the IsraeliQueue provided recognize the FriendshipFunction provided.*/
 IsraeliQueueError IsraeliQueueAddFriendshipMeasure(IsraeliQueue q, FriendshipFunction newFunc){
     if (!q || !newFunc)  return ISRAELIQUEUE_BAD_PARAM;
-    
-    int n = 0;
-    for (; q->FriendshipFuncs[n] != NULL; n++);
-
-    FriendshipFunction* newFriendshipFuncs = (FriendshipFunction*)malloc((n+1 + 1)*(sizeof(FriendshipFunction)));
-    if (!newFriendshipFuncs)  return ISRAELIQUEUE_ALLOC_FAILED;
-
-    for (int i = 0; i < n; i++){
-        newFriendshipFuncs[i] = q->FriendshipFuncs[i];
-    }
-    newFriendshipFuncs[n] = newFunc;
-    newFriendshipFuncs[n+1] = NULL;
-
-    FriendshipFunction* tmp = q->FriendshipFuncs;
-    free(tmp);
-    q->FriendshipFuncs = newFriendshipFuncs;
-
-    return ISRAELIQUEUE_SUCCESS;
+    lockWriter(q);
+    IsraeliQueueError result = addFriendshipFunction(q, newFunc);
+    unlockWriter(q);
+    return result;
 }
 
 /**@param IsraeliQueue: an IsraeliQueue whose friendship threshold is to be modified
  * @param friendship_threshold: a new friendship threshold for the IsraeliQueue*/
 IsraeliQueueError IsraeliQueueUpdateFriendshipThreshold(IsraeliQueue q, int friendshipThreshold){
     if (!q) return   ISRAELIQUEUE_BAD_PARAM;
+    lockWriter(q);
     q->friendshipThreshold = friendshipThreshold;
+    invalidatePairCache(q);
+    unlockWriter(q);
 
     return ISRAELIQUEUE_SUCCESS;
 }
@@ -251,7 +1258,10 @@ IsraeliQueueError IsraeliQueueUpdateFriendshipThreshold(IsraeliQueue q, int frie
  * @param friendship_threshold: a new rivalry threshold for the IsraeliQueue*/
 IsraeliQueueError IsraeliQueueUpdateRivalryThreshold(IsraeliQueue q, int rivalryThreshold){
     if (!q) return   ISRAELIQUEUE_BAD_PARAM;
+    lockWriter(q);
     q->rivalryThreshold = rivalryThreshold;
+    invalidatePairCache(q);
+    unlockWriter(q);
 
     return ISRAELIQUEUE_SUCCESS;
 }
@@ -259,28 +1269,112 @@ IsraeliQueueError IsraeliQueueUpdateRivalryThreshold(IsraeliQueue q, int rivalry
 /**Returns the number of elements of the given queue. If the parameter is NULL, 0
  * is returned.*/
 int IsraeliQueueSize(IsraeliQueue q){
-    if (!q || !(q->head))  return 0;
+    if (!q)  return 0;
 
-    israeliNode* tmp = q->head;
-    int n = 1;
-    while(tmp->next){
-        n++;
-        tmp = tmp->next;
+    lockHead(q);
+    assert(q->size == countIsraeliNodes(q));
+    int size = q->size;
+    unlockHead(q);
+    return size;
+}
+
+#ifndef NDEBUG
+// walks the storage actually holding the queue's elements, used to verify the maintained size in debug builds
+// returns how many elements it found, or -1 if the storage is broken: a link that doesn't match its neighbour,
+// an element missing from its slot, a snapshot its source doesn't list, or a hash index that doesn't count
+// every element once
+int countIsraeliNodes(IsraeliQueue q){
+    if (!q) return 0;
+    int n = 0;
+    if (q->source){ // a snapshot: its elements are the next size ones of the source, from shared on
+        IsraeliQueue listed = q->source->snapshots;
+        while (listed && listed != q){
+            listed = listed->nextSnapshot;
+        }
+        if (!listed || q->source->source || q->shared.owner != q->source)  return -1;
+        if (isArrayStorage(q->source)){
+            israeliArray* arr = &(q->source->array);
+            if (q->shared.index < 0 || q->shared.index + q->size > arr->capacity)  return -1;
+            for (; n < q->size; n++){
+                if (!(arr->elements[q->shared.index + n]))  return -1;
+            }
+            return n;
+        }
+        // the nodes the source dequeued since are retired, not freed, so they still lead to its list
+        israeliNode* node = q->shared.node;
+        for (; n < q->size; n++){
+            if (!node || !(node->element_ptr))  return -1;
+            node = node->next;
+        }
+        return n;
+    }
+
+    if (isArrayStorage(q)){
+        israeliArray* arr = &(q->array);
+        if (q->size > 0 && (arr->front < 0 || arr->front + q->size > arr->capacity))  return -1;
+        for (; n < q->size; n++){
+            if (!(arr->elements[arr->front + n]))  return -1;
+        }
+    }
+    else{
+        israeliNode* previous = NULL;
+        for (israeliNode* tmp = q->head; tmp != NULL; tmp = tmp->next){
+            if (tmp->previous != previous || !(tmp->element_ptr))  return -1;
+            previous = tmp;
+            n++;
+        }
+        if (previous != q->last)  return -1;
+    }
+
+    if (q->index.entries){
+        int indexed = 0;
+        for (size_t i = 0; i <= q->index.mask; i++){
+            indexed += q->index.entries[i].count;
+        }
+        if (indexed != n)  return -1;
     }
     return n;
 }
+#endif
 
 /**Removes and returns the foremost element of the provided queue. If the parameter
- * is NULL or a pointer to an empty queue, NULL is returned.*/
+ * is NULL or a pointer to an empty queue, NULL is returned. It can't fail otherwise, even while
+ * snapshots share the queue's elements, so NULL always means there was nothing to dequeue.*/
 void* IsraeliQueueDequeue(IsraeliQueue q){
-    if (!q || !(q->head))  return NULL;
+    if (q && q->concurrency)  return dequeueConcurrent(q);
+    if (!q || q->size == 0)  return NULL;
+    if (q->source){ // only moves past the shared element
+        void* element = cursorNext(&(q->shared), NULL, NULL);
+        q->size--;
+        if (q->size == 0)  removeSnapshot(q);
+        return element;
+    }
+    // nothing is copied for the snapshots sharing q's elements: the array entries stay where they are, and a
+    // dequeued node is only retired, so a dequeue can't fail
+    if (isArrayStorage(q)){
+        void* element = q->array.elements[q->array.front];
+        q->array.front++;
+        q->size--;
+        if (q->size == 0)  q->array.front = 0; // start over from the beginning of the arrays
+        removeFromIndex(q, element);
+        return element;
+    }
 
     void* tmp = q->head->element_ptr;
     israeliNode* tmpIsraeliNode = q->head;
 
     q->head = tmpIsraeliNode->next; // remove the head
     if (q->head != NULL)  q->head->previous = NULL;
-    free(tmpIsraeliNode);
+    else                  q->last = NULL; // queue is now empty
+    if (q->snapshots){ // they may still read it, its next link stays as it is
+        tmpIsraeliNode->previous = q->retired;
+        q->retired = tmpIsraeliNode;
+    }
+    else{
+        freeNode(q, tmpIsraeliNode);
+    }
+    q->size--;
+    removeFromIndex(q, tmp);
     return tmp;
 }
 
@@ -290,8 +1384,38 @@ void* IsraeliQueueDequeue(IsraeliQueue q){
  * parameter is NULL, false is returned.*/
 bool IsraeliQueueContains(IsraeliQueue q, void* element){
     if (!q || !element)  return false;
-    
+
+    lockHead(q);
+    bool contains = containsElement(q, element);
+    unlockHead(q);
+    return contains;
+}
+
+bool containsElement(IsraeliQueue q, void* element){
+    if (q->options.hashFunc && !(q->source))  return indexContains(q, element);
+    if (q->options.hashFunc && q->size == q->source->size)  return indexContains(q->source, element); // same elements
+
     int same = q->ComparisonFunc(element, element); // defining SAME
+    if (q->source){
+        israeliCursor cursor;
+        startCursor(&cursor, q);
+        void* cur;
+        while ((cur = cursorNext(&cursor, NULL, NULL)) != NULL){
+            if (q->ComparisonFunc(cur, element) == same){
+                return true;
+            }
+        }
+        return false;
+    }
+    if (isArrayStorage(q)){
+        void** elements = q->array.elements + q->array.front;
+        for (int i = 0; i < q->size; i++){
+            if (q->ComparisonFunc(elements[i], element) == same){
+                return true;
+            }
+        }
+        return false;
+    }
     israeliNode* cur = q->head;
     while (cur){
         if (q->ComparisonFunc(cur->element_ptr, element) == same){
@@ -303,155 +1427,278 @@ bool IsraeliQueueContains(IsraeliQueue q, void* element){
     return false;
 }
 
+/**@param out: a buffer with room for at least n elements
+ * @param n: how many elements to read
+ *
+ * Writes the first n elements of the queue (all of them if it has fewer) to out, foremost first,
+ * without changing the queue. Returns the number of elements written. If the queue or out is NULL
+ * or n is negative, -1 is returned.*/
+int IsraeliQueuePeekN(IsraeliQueue q, void** out, int n){
+    if (!q || !out || n < 0)  return -1;
+
+    lockHead(q);
+    int count = peekElements(q, out, n);
+    unlockHead(q);
+    return count;
+}
+
+int peekElements(IsraeliQueue q, void** out, int n){
+    israeliCursor cursor;
+    startCursor(&cursor, q);
+    if (cursor.remaining > n)  cursor.remaining = n; // stop after n elements
+    if (isArrayStorage(cursor.owner)){
+        if (cursor.remaining > 0){ // an empty queue may have no arrays at all
+            memcpy(out, cursor.owner->array.elements + cursor.index, cursor.remaining * sizeof(void*));
+        }
+        return cursor.remaining;
+    }
+    int count = 0;
+    void* element;
+    while ((element = cursorNext(&cursor, NULL, NULL)) != NULL){
+        out[count++] = element;
+    }
+    return count;
+}
+
+/**@param item: an object comparable to the objects in the IsraeliQueue
+ * @param limit: how many elements, from the foremost one, to look at; a negative limit means all of them
+ *
+ * Returns the 0-based position of the foremost element equal to item among the first limit elements,
+ * or -1 if there is none. A queue without a comparison function compares the pointers themselves.
+ * If either parameter is NULL, -1 is returned.*/
+int IsraeliQueueIndexOf(IsraeliQueue q, void* item, int limit){
+    if (!q || !item)  return -1;
+
+    lockHead(q);
+    int position = indexOfElement(q, item, limit);
+    unlockHead(q);
+    return position;
+}
+
+int indexOfElement(IsraeliQueue q, void* item, int limit){
+    israeliCursor cursor;
+    startCursor(&cursor, q);
+    if (limit >= 0 && cursor.remaining > limit)  cursor.remaining = limit; // a bounded walk
+    int same = q->ComparisonFunc ? q->ComparisonFunc(item, item) : 0; // defining SAME
+    void* element;
+    for (int position = 0; (element = cursorNext(&cursor, NULL, NULL)) != NULL; position++){
+        if (q->ComparisonFunc ? q->ComparisonFunc(element, item) == same : element == item){
+            return position;
+        }
+    }
+    return -1;
+}
+
 
-// inserts an israeli node into the queue by updating the NEXT pointers only
-// inserts the node AFTER foremostPos
-// In the case of (foremostPos == NULL) the Node is inserted at the end of the queue
-IsraeliQueueError insertIsraeliNode(IsraeliQueue q, israeliNode* foremostPos, israeliNode* item_israeliNode){
-    if (!q || !foremostPos || !item_israeliNode)  return ISRAELIQUEUE_BAD_PARAM; // bad parameters
+// inserts an israeli node into the queue AFTER foremostPos, keeping both NEXT and PREVIOUS pointers valid
+// In the case of an empty queue foremostPos must be NULL, and the node becomes the only one in the queue
+IsraeliQueueError insertIsraeliNode(IsraeliQueue q, israeliNode* foremostPos, israeliNode* item_israeliNode, bool lastIsFriend){
+    if (!q || !item_israeliNode || (!foremostPos && q->head))  return ISRAELIQUEUE_BAD_PARAM; // bad parameters
 
     if (!(q->head)){ // empty queue
+        item_israeliNode->next = NULL;
+        item_israeliNode->previous = NULL;
         q->head = item_israeliNode;
         q->last = item_israeliNode;
     }
-    
-    if (foremostPos == q->last){ // no position to skip to, put last
-        q->last->next = item_israeliNode;
+    else if (foremostPos == q->last){ // no position to skip to, put last
         item_israeliNode->next = NULL;
+        item_israeliNode->previous = q->last;
+        q->last->next = item_israeliNode;
         q->last = item_israeliNode;
-        if (areFriends(q, foremostPos->element_ptr, item_israeliNode->element_ptr)){
+        if (lastIsFriend){
             foremostPos->friendsPassed++;
         }
     }
     else{ // skip to position
         item_israeliNode->next = foremostPos->next;
+        item_israeliNode->previous = foremostPos;
+        foremostPos->next->previous = item_israeliNode;
         foremostPos->next = item_israeliNode;
         foremostPos->friendsPassed++;
     }
+    q->size++;
 
     return ISRAELIQUEUE_SUCCESS;
 }
 
-israeliNode* findPrevious(IsraeliQueue q, israeliNode* cur){
-    if (!q || !cur || !(q->head)) return NULL; // bad parameters
+// takes a node out of the queue without freeing it, using its PREVIOUS pointer instead of searching for it
+void unlinkIsraeliNode(IsraeliQueue q, israeliNode* node){
+    if (!q || !node) return; // bad parameters
 
-    if (cur == q->head) return NULL; // head previous is NULL
-    israeliNode* node = q->head;
-    while (node){
-        if (node->next == cur){
-            return node;
-        }
-        node = node->next;
-    }
+    if (node->previous)  node->previous->next = node->next;
+    else                 q->head = node->next;
+    if (node->next)      node->next->previous = node->previous;
+    else                 q->last = node->previous;
 
-    return NULL; // shouldn't happen
+    node->next = NULL;
+    node->previous = NULL;
+    q->size--;
 }
 
 /**Advances each item in the queue to the foremost position accessible to it,
  * from the back of the queue frontwards.*/
 IsraeliQueueError IsraeliQueueImprovePositions(IsraeliQueue q){
-    if (!q)          return ISRAELIQUEUE_BAD_PARAM;
-    if (!(q->head))  return ISRAELIQUEUE_SUCCESS;
+    if (!q)  return ISRAELIQUEUE_BAD_PARAM;
+
+    lockWriter(q);
+    lockHead(q);
+    IsraeliQueueError result = improvePositions(q);
+    unlockHead(q);
+    unlockWriter(q);
+    return result;
+}
 
-    israeliNode* cur = q->last;
-    israeliNode* previousOG; // the previous in the OG queue
-    israeliNode* curPrevious;
+IsraeliQueueError improvePositions(IsraeliQueue q){
+    if (q->size == 0)    return ISRAELIQUEUE_SUCCESS;
+    if (prepareWrite(q) != ISRAELIQUEUE_SUCCESS)  return ISRAELIQUEUE_ALLOC_FAILED;
+    if (isArrayStorage(q))  return improvePositionsArray(q);
 
-    israeliNode* foremostPos;
-    while (cur){
-        previousOG = cur->previous;
-        curPrevious = findPrevious(q, cur);
-        // remove cur from queue (by updating the NEXT pointers)
-        // we keep the PREVIOUS pointers unchanged so we could improve positions properly
-            if (curPrevious != NULL){
-                curPrevious->next = cur->next;
-            }
-            else{ // cur is head
-                q->head = cur->next;
-            }
-            if (!(cur->next)){ // cur is last
-                q->last = curPrevious;
-            }
-        // enque them again
-            foremostPos = findForemostPos(q, cur->element_ptr);
-            if (!foremostPos)  return ISRAELI_QUEUE_ERROR;
-            if (insertIsraeliNode(q, foremostPos, cur) != ISRAELIQUEUE_SUCCESS){
-                return ISRAELI_QUEUE_ERROR;
-            }
-            cur = previousOG;
+    // the original order, nodes are moved around while going over it
+    israeliNode** originalOrder = (israeliNode**)malloc(q->size * sizeof(israeliNode*));
+    if (!originalOrder)  return ISRAELIQUEUE_ALLOC_FAILED;
+    int n = 0;
+    for (israeliNode* node = q->head; node != NULL; node = node->next){
+        originalOrder[n++] = node;
     }
-    // update the PREVIOUS pointers
-    cur = q->head;
-    cur->previous = NULL;
-    while(cur->next){
-        cur->next->previous = cur;
-        cur = cur->next;
+
+    israeliNode* cur;
+    israeliNode* foremostPos;
+    bool lastIsFriend;
+    for (int i = n - 1; i >= 0; i--){
+        cur = originalOrder[i];
+        unlinkIsraeliNode(q, cur);
+        // enqueue it again, keeping its counters
+        foremostPos = findForemostPos(q, cur->element_ptr, &lastIsFriend);
+        if (insertIsraeliNode(q, foremostPos, cur, lastIsFriend) != ISRAELIQUEUE_SUCCESS){
+            free(originalOrder);
+            return ISRAELI_QUEUE_ERROR;
+        }
     }
+    free(originalOrder);
+    assert(q->size == countIsraeliNodes(q)); // nodes were only moved
 
     return ISRAELIQUEUE_SUCCESS;
 }
 
-bool isMergeDone(IsraeliQueue* qArr){
-    for (int i = 0; qArr[i] != NULL; i++){
-        if (qArr[i]->head != NULL){
-            return false;
+// the array counterpart of IsraeliQueueImprovePositions
+// every element is tagged with its original position, so it can be found again after the others moved
+IsraeliQueueError improvePositionsArray(IsraeliQueue q){
+    israeliArray* arr = &(q->array);
+    arr->tags = (int*)malloc(arr->capacity * sizeof(int));
+    if (!(arr->tags))  return ISRAELIQUEUE_ALLOC_FAILED;
+    for (int i = 0; i < q->size; i++){
+        arr->tags[arr->front + i] = i;
+    }
+
+    void* element; int friendsPassed; int rivalsBlocked;
+    int at; int foremostIndex; bool lastIsFriend;
+    for (int original = q->size - 1; original >= 0; original--){
+        for (at = 0; arr->tags[arr->front + at] != original; at++);
+        element = arr->elements[arr->front + at];
+        friendsPassed = arr->friendsPassed[arr->front + at];
+        rivalsBlocked = arr->rivalsBlocked[arr->front + at];
+        // remove it by closing the gap from the back, which leaves room for placing it again without growing
+        moveArrayBlock(arr, arr->front + at, arr->front + at + 1, q->size - at - 1);
+        q->size--;
+
+        foremostIndex = findForemostIndex(q, element, &lastIsFriend);
+        if (placeInArray(q, foremostIndex, element, friendsPassed, rivalsBlocked, lastIsFriend) != ISRAELIQUEUE_SUCCESS){
+            free(arr->tags);
+            arr->tags = NULL;
+            return ISRAELI_QUEUE_ERROR;
         }
+        arr->tags[arr->front + foremostIndex + 1] = original;
     }
 
-    return true;
+    free(arr->tags);
+    arr->tags = NULL;
+    return ISRAELIQUEUE_SUCCESS;
 }
 
-int abs(int n){
-    if (n < 0) return -n;
-    return n;
+uint64_t absThreshold(int n){ // INT_MIN included
+    if (n < 0) return (uint64_t)(-(int64_t)n);
+    return (uint64_t)n;
 }
 
-unsigned int power(int n, int exp){
-    unsigned res = 1;
-    for(int i = 0; i < exp; i++){
+uint64_t power(uint64_t n, int exp){ // saturates at UINT64_MAX instead of overflowing
+    uint64_t res = 1;
+    for(int i = 0; i < exp && res != 0; i++){
+        if (n != 0 && res > UINT64_MAX / n)  return UINT64_MAX;
         res *= n;
     }
     return res;
 }
 
-int findNRoot(unsigned int num, int n){ // upper integer
-    int res = 0;
+uint64_t findNRoot(uint64_t num, int n){ // upper integer
+    uint64_t res = (uint64_t)ceill(powl((long double)num, 1.0L / n)); // close guess, fixed exactly below
+    while(res > 0 && power(res - 1, n) >= num){
+        res--;
+    }
     while(power(res, n) < num){
         res++;
     }
     return res;
 }
 
+// upper integer of the n-th root of the number whose logarithm is logSum, for products too big for 64 bits
+// a root that is an integer up to rounding errors (such as the root of equal thresholds) is kept as is
+uint64_t findLogNRoot(long double logSum, int n){
+    long double root = expl(logSum / n);
+    long double nearest = roundl(root);
+    if (fabsl(root - nearest) <= nearest * 1e-15L)  return (uint64_t)nearest;
+    return (uint64_t)ceill(root);
+}
+
 int findMergedFriendshipThreshold(IsraeliQueue* qArr){
     if (qArr[0]) return 0; // bad parameter
 
-    int friendshipThreshold = 0;
     int friendshipThresholdSum = 0;
     int i = 0;
     for ( ; qArr[i]; i++){
         friendshipThresholdSum += qArr[i]->friendshipThreshold;
     }
+    if (i == 0) return 0;
     
     return friendshipThresholdSum / i;
 }
 
+// the upper integer of the geometric mean of the absolute rivalry thresholds, in O(n)
+// the product is kept exactly while it fits in 64 bits and as a sum of logarithms after that
 int findMergedRivalryThreshold(IsraeliQueue* qArr){
-    unsigned int multiplication = 1;
+    uint64_t multiplication = 1;
+    long double logSum = 0;
+    bool overflowed = false;
     int i = 0;
     for(; qArr[i] ; i++){
-        multiplication *= (unsigned int)abs(qArr[i]->rivalryThreshold);
+        uint64_t threshold = absThreshold(qArr[i]->rivalryThreshold);
+        if (threshold == 0)  return 0; // the product is 0 whatever the other thresholds are
+        logSum += logl((long double)threshold);
+        if (!overflowed && multiplication > UINT64_MAX / threshold){
+            overflowed = true;
+        }
+        if (!overflowed){
+            multiplication *= threshold;
+        }
     }
-    return findNRoot(multiplication, i);
+    if (i == 0)  return 0; // bad parameter
+
+    uint64_t root = overflowed ? findLogNRoot(logSum, i) : findNRoot(multiplication, i);
+    return root > INT_MAX ? INT_MAX : (int)root; // only when all the thresholds are INT_MIN
 }
 
 
-/**@param q_arr: a NULL-terminated array of IsraeliQueues
- * @param ComparisonFunction: a comparison function for the merged queue
- *
- * Merges all queues in q_arr into a single new queue, with parameters the parameters described
- * in the exercise. Each queue in q_arr enqueues its head in the merged queue, then lets the next
- * one enqueue an item, in the order defined by q_arr. In the event of any error during execution, return NULL.*/
-IsraeliQueue IsraeliQueueMerge(IsraeliQueue* qArr, ComparisonFunction ComparisonFunc){
+// takes the next item of a merge input, dequeueing it unless the inputs are kept
+void* nextMergeItem(israeliMergeInput* input, bool keepInputs){
+    if (!keepInputs){
+        input->cursor.remaining--;
+        return IsraeliQueueDequeue(input->q);
+    }
+    return cursorNext(&(input->cursor), NULL, NULL);
+}
+
+// merges the queues round robin, only going over the inputs that still have items
+IsraeliQueue mergeQueues(IsraeliQueue* qArr, ComparisonFunction ComparisonFunc, bool keepInputs){
     if (!qArr || !(qArr[0])) return NULL; // bad parameter
 
     // Array Length
@@ -487,22 +1734,57 @@ IsraeliQueue IsraeliQueueMerge(IsraeliQueue* qArr, ComparisonFunction Comparison
     free(FriendshipFuncs);
     if (mergedQ == NULL) return NULL; // error
 
-    israeliNode* cur;
+    // the inputs that still have items, in the order of q_arr
+    israeliMergeInput* inputs = (israeliMergeInput*)malloc(n * sizeof(israeliMergeInput));
+    if (!inputs){
+        IsraeliQueueDestroy(mergedQ);
+        return NULL;
+    }
+    int active = 0;
+    for (int i = 0; i < n; i++){
+        if (qArr[i]->size == 0)  continue;
+        inputs[active].q = qArr[i];
+        startCursor(&(inputs[active].cursor), qArr[i]);
+        active++;
+    }
+
     void* item;
-    int i = 0;
-    while (!isMergeDone(qArr)){
-        cur = qArr[i % n]->head;
-        if (!cur){
-            i++;
-            continue;
-        }
-        item = IsraeliQueueDequeue(qArr[i % n]);
-        if (!item || IsraeliQueueEnqueue(mergedQ, item) != ISRAELIQUEUE_SUCCESS){ // errors
-            IsraeliQueueDestroy(mergedQ);
-            return NULL;
+    int stillActive;
+    while (active > 0){ // every round gives each remaining input one turn
+        stillActive = 0;
+        for (int i = 0; i < active; i++){
+            item = nextMergeItem(&(inputs[i]), keepInputs);
+            if (!item || IsraeliQueueEnqueue(mergedQ, item) != ISRAELIQUEUE_SUCCESS){ // errors
+                free(inputs);
+                IsraeliQueueDestroy(mergedQ);
+                return NULL;
+            }
+            if (inputs[i].cursor.remaining > 0){
+                inputs[stillActive++] = inputs[i];
+            }
         }
-        i++;
+        active = stillActive;
     }
 
+    free(inputs);
     return mergedQ;
-}
\ No newline at end of file
+}
+
+/**@param q_arr: a NULL-terminated array of IsraeliQueues
+ * @param ComparisonFunction: a comparison function for the merged queue
+ *
+ * Merges all queues in q_arr into a single new queue, with parameters the parameters described
+ * in the exercise. Each queue in q_arr enqueues its head in the merged queue, then lets the next
+ * one enqueue an item, in the order defined by q_arr. In the event of any error during execution, return NULL.*/
+IsraeliQueue IsraeliQueueMerge(IsraeliQueue* qArr, ComparisonFunction ComparisonFunc){
+    return mergeQueues(qArr, ComparisonFunc, false);
+}
+
+/**@param q_arr: a NULL-terminated array of IsraeliQueues
+ * @param ComparisonFunction: a comparison function for the merged queue
+ *
+ * Same as IsraeliQueueMerge, except that the queues in q_arr are left unchanged: their elements are
+ * copied into the merged queue instead of being dequeued. In the event of any error during execution, return NULL.*/
+IsraeliQueue IsraeliQueueMergeCopy(IsraeliQueue* qArr, ComparisonFunction ComparisonFunc){
+    return mergeQueues(qArr, ComparisonFunc, true);
+}
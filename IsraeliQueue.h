@@ -12,6 +12,7 @@ typedef struct IsraeliQueue_t * IsraeliQueue;
 
 typedef int (*FriendshipFunction)(void*,void*);
 typedef int (*ComparisonFunction)(void*,void*);
+typedef unsigned long (*HashFunction)(void*);
 
 typedef enum { ISRAELIQUEUE_SUCCESS, ISRAELIQUEUE_ALLOC_FAILED, ISRAELIQUEUE_BAD_PARAM, ISRAELI_QUEUE_ERROR } IsraeliQueueError;
 
@@ -22,15 +23,89 @@ typedef enum { ISRAELIQUEUE_SUCCESS, ISRAELIQUEUE_ALLOC_FAILED, ISRAELIQUEUE_BAD
  * ISRAELI_QUEUE_ERROR: Indicates any error beyond the above.
  * */
 
+/**Storage engines of an IsraeliQueue:
+ * ISRAELIQUEUE_STORAGE_LIST: a doubly linked list of nodes (the default).
+ * ISRAELIQUEUE_STORAGE_ARRAY: contiguous arrays of elements and their friend/rival counters, so scanning
+ * the queue reads memory sequentially. Inserting in the middle moves the shorter side of the array by one.*/
+typedef enum { ISRAELIQUEUE_STORAGE_LIST, ISRAELIQUEUE_STORAGE_ARRAY } IsraeliQueueStorage;
+
+/**Optional settings for IsraeliQueueCreateWithOptions. A zero-initialized struct gives the same
+ * queue as IsraeliQueueCreate.
+ * nodePoolSlabSize: if positive, the queue's nodes are served from a private pool that grows in slabs
+ * of this many nodes and recycles dequeued nodes, instead of one malloc/free per element.
+ * Ignored by ISRAELIQUEUE_STORAGE_ARRAY, which has no nodes.
+ * storage: the storage engine of the queue.
+ * pairCacheSize: if positive, the queue remembers the friendship/rivalry verdict of up to this many
+ * (element, element) pairs (rounded up to a power of two), keyed by the element pointers, so scoring
+ * the same pair again doesn't call the friendship functions. Only valid when the friendship functions
+ * always return the same score for the same pair of pointers. The cache is emptied whenever a
+ * friendship function is added or a threshold is updated.
+ * hashFunc: if not NULL, the queue keeps a hash index of its elements, making IsraeliQueueContains
+ * constant time on average instead of comparing against every element. Elements that are equal
+ * according to the comparison function must have the same hash.*/
+typedef struct IsraeliQueueOptions {
+    int nodePoolSlabSize;
+    IsraeliQueueStorage storage;
+    int pairCacheSize;
+    HashFunction hashFunc;
+} IsraeliQueueOptions;
+
+/**Node pool usage, as reported by IsraeliQueueGetPoolStats:
+ * slabs: number of slabs allocated by the pool.
+ * capacity: number of nodes in all the slabs.
+ * inUse: number of nodes currently holding an element.
+ * peakInUse: the largest inUse ever reached, useful for sizing nodePoolSlabSize.
+ * allocations: number of nodes handed out so far.
+ * reused: how many of those allocations were served by recycling a dequeued node.*/
+typedef struct IsraeliQueuePoolStats {
+    int slabs;
+    int capacity;
+    int inUse;
+    int peakInUse;
+    long allocations;
+    long reused;
+} IsraeliQueuePoolStats;
+
+/**Pair cache usage, as reported by IsraeliQueueGetCacheStats:
+ * hits: pairs whose verdict was found in the cache.
+ * misses: pairs that had to be scored by the friendship functions.*/
+typedef struct IsraeliQueueCacheStats {
+    long hits;
+    long misses;
+} IsraeliQueueCacheStats;
+
 /**Creates a new IsraeliQueue_t object with the provided friendship functions, a NULL-terminated array,
  * comparison function, friendship threshold and rivalry threshold. Returns a pointer
  * to the new object. In case of failure, return NULL.*/
 IsraeliQueue IsraeliQueueCreate(FriendshipFunction *, ComparisonFunction, int, int);
 
-/**Returns a new queue with the same elements as the parameter. If the parameter is NULL or any error occured during
+/**Same as IsraeliQueueCreate, with the additional settings described in IsraeliQueueOptions.
+ * A NULL options pointer is the same as IsraeliQueueCreate. In case of failure, return NULL.*/
+IsraeliQueue IsraeliQueueCreateWithOptions(FriendshipFunction *, ComparisonFunction, int, int, const IsraeliQueueOptions *);
+
+/**Same as IsraeliQueueCreate, for a queue shared between threads: every function may be called on it
+ * from several threads at once, except IsraeliQueueDestroy, and IsraeliQueueMerge and IsraeliQueueMergeCopy
+ * on an array holding it. The friendship and comparison functions may be called from several threads at once.
+ * Dequeues don't wait for an enqueue to scan the queue, only for it to place its item; enqueues (and any other
+ * change of the queue) wait for each other. Its clones and snapshots are ordinary queues.
+ * A concurrent queue always has the default options: a linked list of malloc'd nodes, with no node pool,
+ * pair cache or hash index, which the two locks of the queue don't protect.
+ * In case of failure, return NULL.*/
+IsraeliQueue IsraeliQueueCreateConcurrent(FriendshipFunction *, ComparisonFunction, int, int);
+
+/**Returns a new queue with the same elements and options as the parameter. If the parameter is NULL or any error occured during
  * the execution of the function, NULL is returned.*/
 IsraeliQueue IsraeliQueueClone(IsraeliQueue q);
 
+/**Returns a copy-on-write snapshot of the queue: a new queue with the same elements and options,
+ * which shares the elements of the parameter instead of copying them. Dequeueing the snapshot, asking
+ * for its size or searching it costs nothing extra; the snapshot copies the elements it still has only
+ * when it is changed in any other way, or right before the parameter is destroyed or changed in any way
+ * other than a dequeue. The parameter keeps the memory of the elements it dequeues while a snapshot
+ * shares them, so that its dequeues never copy anything and never fail.
+ * If the parameter is NULL or any error occured during the execution of the function, NULL is returned.*/
+IsraeliQueue IsraeliQueueSnapshot(IsraeliQueue q);
+
 /**@param IsraeliQueue: an IsraeliQueue created by IsraeliQueueCreate
  *
  * Deallocates all memory allocated by IsraeliQueueCreate for the object pointed to by
@@ -43,6 +118,16 @@ void IsraeliQueueDestroy(IsraeliQueue);
  * Places the item in the foremost position accessible to it.*/
 IsraeliQueueError IsraeliQueueEnqueue(IsraeliQueue, void *);
 
+/**@param IsraeliQueue: an IsraeliQueue in which to insert the items.
+ * @param items: an array of n items to enqueue
+ * @param n: the number of items
+ *
+ * Places the items one after the other, each in the foremost position accessible to it, exactly as
+ * n calls to IsraeliQueueEnqueue would. A queue without friendship functions appends them all without
+ * scanning it. If any item is NULL nothing is enqueued and ISRAELIQUEUE_BAD_PARAM is returned; on any
+ * other error the items before the failing one stay enqueued.*/
+IsraeliQueueError IsraeliQueueEnqueueBatch(IsraeliQueue, void **, int);
+
 /**@param IsraeliQueue: an IsraeliQueue to which the function is to be added
  * @param FriendshipFunction: a FriendshipFunction to be recognized by the IsraeliQueue
  * going forward.
@@ -63,7 +148,8 @@ IsraeliQueueError IsraeliQueueUpdateRivalryThreshold(IsraeliQueue, int);
 int IsraeliQueueSize(IsraeliQueue);
 
 /**Removes and returns the foremost element of the provided queue. If the parameter
- * is NULL or a pointer to an empty queue, NULL is returned.*/
+ * is NULL or a pointer to an empty queue, NULL is returned. It can't fail otherwise, even while
+ * snapshots share the queue's elements, so NULL always means there was nothing to dequeue.*/
 void* IsraeliQueueDequeue(IsraeliQueue);
 
 /**@param item: an object comparable to the objects in the IsraeliQueue
@@ -72,6 +158,22 @@ void* IsraeliQueueDequeue(IsraeliQueue);
  * parameter is NULL, false is returned.*/
 bool IsraeliQueueContains(IsraeliQueue, void *);
 
+/**@param out: a buffer with room for at least n elements
+ * @param n: how many elements to read
+ *
+ * Writes the first n elements of the queue (all of them if it has fewer) to out, foremost first,
+ * without changing the queue. Returns the number of elements written. If the queue or out is NULL
+ * or n is negative, -1 is returned.*/
+int IsraeliQueuePeekN(IsraeliQueue, void **, int);
+
+/**@param item: an object comparable to the objects in the IsraeliQueue
+ * @param limit: how many elements, from the foremost one, to look at; a negative limit means all of them
+ *
+ * Returns the 0-based position of the foremost element equal to item among the first limit elements,
+ * or -1 if there is none. A queue without a comparison function compares the pointers themselves.
+ * If either parameter is NULL, -1 is returned.*/
+int IsraeliQueueIndexOf(IsraeliQueue, void *, int);
+
 /**Advances each item in the queue to the foremost position accessible to it,
  * from the back of the queue frontwards.*/
 IsraeliQueueError IsraeliQueueImprovePositions(IsraeliQueue);
@@ -84,4 +186,23 @@ IsraeliQueueError IsraeliQueueImprovePositions(IsraeliQueue);
  * one enqueue an item, in the order defined by q_arr. In the event of any error during execution, return NULL.*/
 IsraeliQueue IsraeliQueueMerge(IsraeliQueue*,ComparisonFunction);
 
+/**@param q_arr: a NULL-terminated array of IsraeliQueues
+ * @param ComparisonFunction: a comparison function for the merged queue
+ *
+ * Same as IsraeliQueueMerge, except that the queues in q_arr are left unchanged: their elements are
+ * copied into the merged queue instead of being dequeued. In the event of any error during execution, return NULL.*/
+IsraeliQueue IsraeliQueueMergeCopy(IsraeliQueue*,ComparisonFunction);
+
+/**@param stats: where to write the node pool usage of the queue
+ *
+ * Fills stats with the node pool usage of the queue. A queue created without a node pool reports
+ * all zeros. If either parameter is NULL, ISRAELIQUEUE_BAD_PARAM is returned.*/
+IsraeliQueueError IsraeliQueueGetPoolStats(IsraeliQueue, IsraeliQueuePoolStats *);
+
+/**@param stats: where to write the pair cache usage of the queue
+ *
+ * Fills stats with the hit and miss counts of the queue's pair cache. A queue created without a pair
+ * cache reports all zeros. If either parameter is NULL, ISRAELIQUEUE_BAD_PARAM is returned.*/
+IsraeliQueueError IsraeliQueueGetCacheStats(IsraeliQueue, IsraeliQueueCacheStats *);
+
 #endif //PROVIDED_ISRAELIQUEUE_H
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "StagingRing.h"
+#include <stdint.h>
+
+#define STAGING_RING_MAX_CAPACITY (1 << 30)
+#define STAGING_RING_CACHE_LINE 64
+#define DRAIN_CHUNK 64 // items handed to IsraeliQueueEnqueueBatch at once
+
+// a slot's sequence tells whose turn it is: position p may be claimed by a producer once it is p, and the
+// item pushed at p may be taken by the owner once it is p + 1; taking it makes it p + capacity, the next
+// position to use the slot
+// sequence and tail are only accessed through the GCC __atomic builtins, C99 has no atomic types
+typedef struct stagingSlot {
+    size_t sequence;
+    void* item;
+} stagingSlot;
+
+// tail is written by every producer and head only by the owner, so a cache line of padding keeps them
+// apart wherever malloc places the ring
+struct StagingRing_t {
+    size_t tail;                                        // the next position to claim
+    char tailLine[STAGING_RING_CACHE_LINE - sizeof(size_t)];
+    size_t head;                                        // the position of the foremost item
+    size_t mask;                                        // capacity - 1
+    stagingSlot* slots;
+};
+
+// HELPER FUNCTIONS DECLARATIONS
+stagingSlot* readySlot(StagingRing ring, size_t position);
+void releaseSlots(StagingRing ring, int count);
+
+StagingRing StagingRingCreate(int capacity){
+    if (capacity <= 0 || capacity > STAGING_RING_MAX_CAPACITY)  return NULL;
+    size_t size = 2; // with a single slot, "free for p + 1" and "holding the item of p" would look the same
+    while (size < (size_t)capacity){
+        size <<= 1;
+    }
+
+    StagingRing ring = (StagingRing)malloc(sizeof(struct StagingRing_t));
+    if (!ring)  return NULL;
+    ring->slots = (stagingSlot*)malloc(size * sizeof(stagingSlot));
+    if (!(ring->slots)){
+        free(ring);
+        return NULL;
+    }
+    for (size_t i = 0; i < size; i++){
+        ring->slots[i].sequence = i;
+        ring->slots[i].item = NULL;
+    }
+    ring->tail = 0;
+    ring->head = 0;
+    ring->mask = size - 1;
+
+    return ring;
+}
+
+void StagingRingDestroy(StagingRing ring){
+    if (!ring)  return;
+
+    free(ring->slots);
+    free(ring);
+}
+
+int StagingRingCapacity(StagingRing ring){
+    if (!ring)  return 0;
+
+    return (int)(ring->mask + 1);
+}
+
+StagingRingError StagingRingPush(StagingRing ring, void* item){
+    if (!ring || !item)  return STAGING_RING_BAD_PARAM;
+
+    size_t position = __atomic_load_n(&(ring->tail), __ATOMIC_RELAXED);
+    stagingSlot* slot;
+    intptr_t turn;
+    while (true){
+        slot = &(ring->slots[position & ring->mask]);
+        turn = (intptr_t)(__atomic_load_n(&(slot->sequence), __ATOMIC_ACQUIRE) - position);
+        if (turn == 0){ // the slot is free for this position, claim it
+            if (__atomic_compare_exchange_n(&(ring->tail), &position, position + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+                break;
+            }
+            // another producer claimed it first, position now holds the new tail
+        }
+        else if (turn < 0){ // the slot still holds the item pushed a lap ago
+            return STAGING_RING_FULL;
+        }
+        else{ // another producer claimed the position meanwhile
+            position = __atomic_load_n(&(ring->tail), __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->item = item;
+    __atomic_store_n(&(slot->sequence), position + 1, __ATOMIC_RELEASE); // publish it to the owner
+    return STAGING_RING_SUCCESS;
+}
+
+// returns the slot of the item pushed at position, or NULL if its push hasn't completed (or started)
+stagingSlot* readySlot(StagingRing ring, size_t position){
+    stagingSlot* slot = &(ring->slots[position & ring->mask]);
+    if (__atomic_load_n(&(slot->sequence), __ATOMIC_ACQUIRE) != position + 1)  return NULL;
+    return slot;
+}
+
+// hands the count foremost slots back to the producers
+void releaseSlots(StagingRing ring, int count){
+    stagingSlot* slot;
+    for (int i = 0; i < count; i++){
+        slot = &(ring->slots[ring->head & ring->mask]);
+        slot->item = NULL;
+        __atomic_store_n(&(slot->sequence), ring->head + ring->mask + 1, __ATOMIC_RELEASE);
+        ring->head++;
+    }
+}
+
+void* StagingRingPop(StagingRing ring){
+    if (!ring)  return NULL;
+
+    stagingSlot* slot = readySlot(ring, ring->head);
+    if (!slot)  return NULL;
+    void* item = slot->item;
+    releaseSlots(ring, 1);
+    return item;
+}
+
+StagingRingError StagingRingDrain(StagingRing ring, IsraeliQueue q, int* drained_ptr){
+    if (drained_ptr)  *drained_ptr = 0;
+    if (!ring || !q)  return STAGING_RING_BAD_PARAM;
+
+    // the items are only released once they are in q, so a failed batch leaves the rest in the ring
+    // only the items claimed before the drain started are taken, so busy producers can't keep it going
+    size_t left = __atomic_load_n(&(ring->tail), __ATOMIC_RELAXED) - ring->head;
+    void* items[DRAIN_CHUNK];
+    stagingSlot* slot;
+    IsraeliQueueError result;
+    int count, size, enqueued;
+    while (left > 0){
+        count = 0;
+        while ((size_t)count < left && count < DRAIN_CHUNK && (slot = readySlot(ring, ring->head + count)) != NULL){
+            items[count++] = slot->item;
+        }
+        if (count == 0)  break; // the foremost push is still in progress
+
+        size = IsraeliQueueSize(q);
+        result = IsraeliQueueEnqueueBatch(q, items, count);
+        if (result != ISRAELIQUEUE_SUCCESS){
+            enqueued = IsraeliQueueSize(q) - size; // the items before the failing one stay enqueued
+            releaseSlots(ring, enqueued);
+            if (drained_ptr)  *drained_ptr += enqueued;
+            return result == ISRAELIQUEUE_ALLOC_FAILED ? STAGING_RING_ALLOC_FAILED : STAGING_RING_ERROR;
+        }
+        releaseSlots(ring, count);
+        if (drained_ptr)  *drained_ptr += count;
+        left -= count;
+    }
+
+    return STAGING_RING_SUCCESS;
+}
@@ -0,0 +1,58 @@
+#ifndef STAGING_RING_H
+#define STAGING_RING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "IsraeliQueue.h"
+
+typedef struct StagingRing_t * StagingRing;
+
+typedef enum { STAGING_RING_SUCCESS, STAGING_RING_FULL, STAGING_RING_ALLOC_FAILED, STAGING_RING_BAD_PARAM, STAGING_RING_ERROR } StagingRingError;
+
+/**Error clarification:
+ * STAGING_RING_SUCCESS: Indicates the function has completed its task successfully with no errors.
+ * STAGING_RING_FULL: Indicates the ring had no free slot for the item, which was not pushed.
+ * STAGING_RING_ALLOC_FAILED: Indicates memory allocation failed during the execution of the function.
+ * STAGING_RING_BAD_PARAM: Indicates an illegal parameter was passed.
+ * STAGING_RING_ERROR: Indicates any error beyond the above.
+ * */
+
+/**A StagingRing is a bounded buffer in front of an IsraeliQueue owned by a single thread: any number of
+ * threads push items into it without locks, and the owning thread drains them into its queue, in the
+ * order they were pushed. A push only claims a slot and writes to it, so producers never wait for the
+ * friendship scan of IsraeliQueueEnqueue, nor for each other beyond retrying a contended claim.
+ * An item becomes visible to the owner once its push returns; an item whose push is still in progress
+ * holds back the items pushed after it.*/
+
+/**@param capacity: the number of items the ring can hold, rounded up to a power of two (at least 2)
+ *
+ * Creates a new empty ring. Returns NULL if capacity isn't positive or on failure.*/
+StagingRing StagingRingCreate(int capacity);
+
+/**Deallocates the ring. The items still in it are not drained.*/
+void StagingRingDestroy(StagingRing);
+
+/**Returns the capacity of the ring, 0 if the parameter is NULL.*/
+int StagingRingCapacity(StagingRing);
+
+/**@param item: the item to stage, not NULL
+ *
+ * Adds the item at the end of the ring. May be called from any number of threads at once.
+ * Returns STAGING_RING_FULL, without waiting, if the ring has no free slot.*/
+StagingRingError StagingRingPush(StagingRing, void* item);
+
+/**Removes and returns the foremost item of the ring, or NULL if there is none.
+ * Must only be called by the owning thread.*/
+void* StagingRingPop(StagingRing);
+
+/**@param q: the queue owned by the calling thread
+ * @param drained_ptr: if not NULL, set to the number of items moved into q
+ *
+ * Enqueues the items pushed before the call into q, in the order they were pushed, with
+ * IsraeliQueueEnqueueBatch, stopping early at an item whose push is still in progress. Must only be called
+ * by the owning thread, and q must not be changed by any other thread meanwhile. On failure, the items
+ * that couldn't be enqueued stay in the ring.*/
+StagingRingError StagingRingDrain(StagingRing, IsraeliQueue q, int* drained_ptr);
+
+#endif
@@ -0,0 +1,152 @@
+#include "testFixtures.h"
+#include <time.h>
+
+// checks that IsraeliQueueEnqueueBatch places n items exactly as n calls to IsraeliQueueEnqueue do, on random
+// queues of every storage engine with 0 to 2 friendship functions and batches of 1 to MAX_BATCH items, then
+// times both ways of filling a queue
+
+#define SEEDS 150
+#define ITEMS 600       // items enqueued in every run
+#define MAX_BATCH 150
+#define POOL_SLAB 16
+#define BENCHMARK_ITEMS 20000
+
+// returns whether both queues hold the same elements in the same order
+bool sameOrder(IsraeliQueue q1, IsraeliQueue q2, void** buffer1, void** buffer2){
+    int size = IsraeliQueuePeekN(q2, buffer2, ITEMS);
+    return size >= 0 && holdsInOrder(q1, buffer2, size, buffer1);
+}
+
+// fills the tables and returns a queue with the given number of functions over them, with the thresholds
+// drawn from the current seed
+IsraeliQueue createRandomQueue(int functionsCount, const IsraeliQueueOptions* options, unsigned testSeed){
+    seedRandom(testSeed);
+    fillTables(-20, 60);
+    int friendshipThreshold = 20 + (int)(nextRandom() % 20);
+    int rivalryThreshold = (int)(nextRandom() % 10);
+    FriendshipFunction functions[] = { table0, table1, NULL };
+    functions[functionsCount] = NULL;
+    return IsraeliQueueCreateWithOptions(functions, compareInts, friendshipThreshold, rivalryThreshold, options);
+}
+
+// runs the same random batches and dequeues on a batch-filled and a sequentially filled queue, returns
+// false on the first difference
+bool runSeed(unsigned testSeed, int functionsCount, const IsraeliQueueOptions* options, int* values, void** items){
+    IsraeliQueue batched = createRandomQueue(functionsCount, options, testSeed);
+    IsraeliQueue sequential = createRandomQueue(functionsCount, options, testSeed);
+    if (!batched || !sequential){
+        IsraeliQueueDestroy(batched);
+        IsraeliQueueDestroy(sequential);
+        return false;
+    }
+
+    void* buffer1[ITEMS];
+    void* buffer2[ITEMS];
+    bool same = true;
+    int count = 0, length, dequeues;
+    while (count < ITEMS && same){
+        length = 1 + (int)(nextRandom() % MAX_BATCH);
+        if (count + length > ITEMS)  length = ITEMS - count;
+        for (int i = count; i < count + length; i++){
+            values[i] = (int)(nextRandom() % FIXTURE_VALUES);
+            items[i] = &values[i];
+        }
+        same = IsraeliQueueEnqueueBatch(batched, items + count, length) == ISRAELIQUEUE_SUCCESS;
+        for (int i = count; i < count + length && same; i++){
+            same = IsraeliQueueEnqueue(sequential, items[i]) == ISRAELIQUEUE_SUCCESS;
+        }
+        count += length;
+        same = same && sameOrder(batched, sequential, buffer1, buffer2);
+
+        dequeues = (int)(nextRandom() % 20); // so that batches land on elements with used up quotas too
+        for (int i = 0; i < dequeues && same; i++){
+            same = IsraeliQueueDequeue(batched) == IsraeliQueueDequeue(sequential);
+        }
+    }
+
+    IsraeliQueueDestroy(batched);
+    IsraeliQueueDestroy(sequential);
+    return same;
+}
+
+// returns the seconds it took to enqueue the items into a new random queue, in one batch or one by one
+// without rivals no element ever runs out of rival quota, so every scan reads the whole queue
+double timeFilling(bool batch, int functionsCount, bool rivals, void** items, int n){
+    IsraeliQueue q = createRandomQueue(functionsCount, NULL, 1);
+    if (!q)  return -1;
+    if (!rivals && IsraeliQueueUpdateRivalryThreshold(q, -100) != ISRAELIQUEUE_SUCCESS){
+        IsraeliQueueDestroy(q);
+        return -1;
+    }
+
+    clock_t start = clock();
+    if (batch){
+        if (IsraeliQueueEnqueueBatch(q, items, n) != ISRAELIQUEUE_SUCCESS){
+            IsraeliQueueDestroy(q);
+            return -1;
+        }
+    }
+    else{
+        for (int i = 0; i < n; i++){
+            if (IsraeliQueueEnqueue(q, items[i]) != ISRAELIQUEUE_SUCCESS){
+                IsraeliQueueDestroy(q);
+                return -1;
+            }
+        }
+    }
+    clock_t end = clock();
+
+    IsraeliQueueDestroy(q);
+    return (double)(end - start) / CLOCKS_PER_SEC;
+}
+
+int main(){
+    IsraeliQueueOptions options[3] = { { 0 }, { 0 }, { 0 } };
+    options[1].storage = ISRAELIQUEUE_STORAGE_ARRAY;
+    options[2].nodePoolSlabSize = POOL_SLAB;
+    const char* names[3] = { "list", "array", "pool" };
+
+    int values[ITEMS];
+    void* items[ITEMS];
+    int failed = 0;
+    for (unsigned testSeed = 1; testSeed <= SEEDS; testSeed++){
+        for (int i = 0; i < 3; i++){
+            if (!runSeed(testSeed, (int)(testSeed % 3), &options[i], values, items)){
+                printf("seed %u, %s storage: the batch differs from single enqueues\n", testSeed, names[i]);
+                failed++;
+            }
+        }
+    }
+    printf("%d of %d runs passed\n", 3 * SEEDS - failed, 3 * SEEDS);
+
+    int* benchmarkValues = (int*)malloc(BENCHMARK_ITEMS * sizeof(int));
+    void** benchmarkItems = (void**)malloc(BENCHMARK_ITEMS * sizeof(void*));
+    if (!benchmarkValues || !benchmarkItems){
+        printf("couldn't allocate the items\n");
+        return 2;
+    }
+    seedRandom(7919);
+    for (int i = 0; i < BENCHMARK_ITEMS; i++){
+        benchmarkValues[i] = (int)(nextRandom() % FIXTURE_VALUES);
+        benchmarkItems[i] = &benchmarkValues[i];
+    }
+    // the first case is how readEnrollment loads a course queue: the measures are only added afterwards
+    int functionsCounts[3] = { 0, 1, 1 };
+    bool rivals[3] = { false, true, false };
+    const char* cases[3] = { "no friendship functions", "one function, with rivals", "one function, no rivals" };
+    double single, batch;
+    printf("enqueueing %d items\n%-38s %12s %12s\n", BENCHMARK_ITEMS, "", "one by one", "one batch");
+    for (int i = 0; i < 3; i++){
+        single = timeFilling(false, functionsCounts[i], rivals[i], benchmarkItems, BENCHMARK_ITEMS);
+        batch = timeFilling(true, functionsCounts[i], rivals[i], benchmarkItems, BENCHMARK_ITEMS);
+        if (single < 0 || batch < 0){
+            printf("benchmark failed\n");
+            break;
+        }
+        printf("%-38s %11.3fs %11.3fs\n", cases[i], single, batch);
+    }
+    free(benchmarkItems);
+    free(benchmarkValues);
+
+    return failed == 0 ? 0 : 1;
+}
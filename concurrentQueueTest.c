@@ -0,0 +1,235 @@
+#define _POSIX_C_SOURCE 199309L // clock_gettime and nanosleep, for the dequeue latencies
+#include "IsraeliQueue.c" // the nodes are internal, their counters are checked against the quotas
+#include "testFixtures.h"
+#include <sched.h>
+#include <time.h>
+
+// stress test of IsraeliQueueCreateConcurrent: in every round several threads enqueue their own items while
+// others dequeue, then the queue is checked while no thread uses it: the list must be well linked, its size
+// right and no element past its friend or rival quota; at the end every item must have been dequeued exactly
+// once, none lost and none twice
+// then the latency of dequeues is measured while slow enqueues scan a long queue: every dequeue makes the
+// scan going on useless, yet none may wait for a scan
+
+#define ROUNDS 50
+#define ENQUEUERS 4
+#define DEQUEUERS 3
+#define ITEMS_PER_ENQUEUER 300  // every round
+#define ITEMS (ROUNDS * ENQUEUERS * ITEMS_PER_ENQUEUER)
+
+#define LATENCY_ITEMS 1000             // in the queue when the slow enqueues start
+#define SLOW_SCORE_NANOSECONDS 20000   // every score of the slow friendship function takes this long
+#define SLOW_ENQUEUES 4
+#define SLOW_DEQUEUES 100
+#define DEQUEUE_PAUSE_NANOSECONDS 1000000
+// a dequeue waiting for a scan of the queue to end would wait longer than this, in seconds
+#define MAX_DEQUEUE_LATENCY (LATENCY_ITEMS * (SLOW_SCORE_NANOSECONDS / 1e9) / 2)
+
+static int values[ITEMS];
+static int dequeuedTimes[ITEMS];
+
+typedef struct Round {
+    IsraeliQueue q;
+    int first;                  // the first item of the round
+    int enqueued;               // items each enqueuer enqueues
+    int dequeues;               // items the dequeuers take out together
+    pthread_mutex_t lock;       // guards taken
+    int taken;
+    bool failed;                // an enqueue failed
+} Round;
+
+typedef struct Worker {
+    Round* round;
+    int id;
+    int* dequeued;              // the items dequeued by a dequeuer, indices into values
+    int count;
+} Worker;
+
+void* enqueuer(void* arg){
+    Worker* worker = (Worker*)arg;
+    Round* round = worker->round;
+    int first = round->first + worker->id * round->enqueued;
+    for (int i = first; i < first + round->enqueued; i++){
+        if (IsraeliQueueEnqueue(round->q, &values[i]) != ISRAELIQUEUE_SUCCESS)  round->failed = true;
+        if (i % 16 == 0)  sched_yield(); // one processor is enough to interleave the threads
+    }
+    return NULL;
+}
+
+// dequeues until the round's share is taken; claims an item before dequeueing it so the queue is left
+// with exactly the items that weren't claimed
+void* dequeuer(void* arg){
+    Worker* worker = (Worker*)arg;
+    Round* round = worker->round;
+    void* item;
+    while (true){
+        pthread_mutex_lock(&(round->lock));
+        bool claimed = round->taken < round->dequeues;
+        if (claimed)  round->taken++;
+        pthread_mutex_unlock(&(round->lock));
+        if (!claimed)  return NULL;
+
+        while ((item = IsraeliQueueDequeue(round->q)) == NULL){
+            sched_yield(); // the enqueuers are behind
+        }
+        worker->dequeued[worker->count++] = (int)((int*)item - values);
+    }
+}
+
+// checks the queue while no thread uses it, returns false on the first broken invariant
+bool checkQueue(IsraeliQueue q, int expectedSize){
+    int count = 0;
+    israeliNode* previous = NULL;
+    for (israeliNode* node = q->head; node != NULL; node = node->next){
+        if (node->previous != previous)  return false;
+        if (node->friendsPassed < 0 || node->friendsPassed > FRIEND_QUOTA)  return false;
+        if (node->rivalsBlocked < 0 || node->rivalsBlocked > RIVAL_QUOTA)  return false;
+        previous = node;
+        count++;
+    }
+    return previous == q->last && count == q->size && count == expectedSize && IsraeliQueueSize(q) == count;
+}
+
+double secondsNow(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// makes every pair friends, after SLOW_SCORE_NANOSECONDS: the foremost position is right behind the head,
+// so any dequeue during a scan means it has to be made again
+int slowFriends(void* item1, void* item2){
+    double end = secondsNow() + SLOW_SCORE_NANOSECONDS / 1e9;
+    while (secondsNow() < end);
+    return 100;
+}
+
+typedef struct LatencyPhase {
+    IsraeliQueue q;
+    int dequeued;
+    double maxLatency;          // of a dequeue, in seconds
+} LatencyPhase;
+
+void* slowDequeuer(void* arg){
+    LatencyPhase* phase = (LatencyPhase*)arg;
+    struct timespec pause = { 0, DEQUEUE_PAUSE_NANOSECONDS };
+    double start, latency;
+    for (int i = 0; i < SLOW_DEQUEUES; i++){
+        nanosleep(&pause, NULL); // lets the enqueues scan meanwhile
+        start = secondsNow();
+        if (IsraeliQueueDequeue(phase->q) != NULL)  phase->dequeued++;
+        latency = secondsNow() - start;
+        if (latency > phase->maxLatency)  phase->maxLatency = latency;
+    }
+    return NULL;
+}
+
+// measures the dequeues while SLOW_ENQUEUES items are enqueued into a long queue, returns false if one of
+// them waited for a scan, or if an item was lost
+bool checkDequeueLatency(){
+    FriendshipFunction noFunctions[] = { NULL };
+    LatencyPhase phase;
+    phase.q = IsraeliQueueCreateConcurrent(noFunctions, compareInts, 30, 0);
+    phase.dequeued = 0;
+    phase.maxLatency = 0;
+    bool passed = phase.q != NULL;
+    for (int i = 0; i < LATENCY_ITEMS && passed; i++){ // nothing to score yet
+        passed = IsraeliQueueEnqueue(phase.q, &values[i]) == ISRAELIQUEUE_SUCCESS;
+    }
+    passed = passed && IsraeliQueueAddFriendshipMeasure(phase.q, slowFriends) == ISRAELIQUEUE_SUCCESS;
+
+    pthread_t thread;
+    if (!passed || pthread_create(&thread, NULL, slowDequeuer, &phase) != 0){
+        IsraeliQueueDestroy(phase.q);
+        return false;
+    }
+    for (int i = 0; i < SLOW_ENQUEUES; i++){
+        if (IsraeliQueueEnqueue(phase.q, &values[LATENCY_ITEMS + i]) != ISRAELIQUEUE_SUCCESS)  passed = false;
+    }
+    pthread_join(thread, NULL);
+
+    printf("slowest of %d dequeues during slow enqueues: %.3f ms, a scan takes over %.2f ms\n", SLOW_DEQUEUES,
+           phase.maxLatency * 1e3, 2 * MAX_DEQUEUE_LATENCY * 1e3);
+    passed = passed && phase.dequeued == SLOW_DEQUEUES && phase.maxLatency < MAX_DEQUEUE_LATENCY &&
+             checkQueue(phase.q, LATENCY_ITEMS + SLOW_ENQUEUES - SLOW_DEQUEUES);
+    IsraeliQueueDestroy(phase.q);
+    return passed;
+}
+
+int main(){
+    seedRandom(31337);
+    fillTables(-20, 60);
+    for (int i = 0; i < ITEMS; i++){
+        values[i] = (int)(nextRandom() % FIXTURE_VALUES);
+    }
+    FriendshipFunction functions[] = { table0, NULL };
+    Round round;
+    round.q = IsraeliQueueCreateConcurrent(functions, compareInts, 30, 0);
+    int* dequeued = (int*)malloc(DEQUEUERS * ITEMS * sizeof(int));
+    if (!(round.q) || !dequeued){
+        printf("couldn't create the queue\n");
+        return 2;
+    }
+    pthread_mutex_init(&(round.lock), NULL);
+    round.failed = false;
+
+    pthread_t threads[ENQUEUERS + DEQUEUERS];
+    Worker workers[ENQUEUERS + DEQUEUERS];
+    for (int i = 0; i < ENQUEUERS + DEQUEUERS; i++){
+        workers[i].round = &round;
+        workers[i].id = i;
+        workers[i].dequeued = dequeued + (i < ENQUEUERS ? 0 : (i - ENQUEUERS) * ITEMS);
+        workers[i].count = 0;
+    }
+
+    int failed = 0, size = 0;
+    for (int r = 0; r < ROUNDS; r++){
+        round.first = r * ENQUEUERS * ITEMS_PER_ENQUEUER;
+        round.enqueued = ITEMS_PER_ENQUEUER;
+        // the queue grows in some rounds and shrinks in others
+        round.dequeues = (int)(nextRandom() % (size + ENQUEUERS * ITEMS_PER_ENQUEUER + 1));
+        round.taken = 0;
+        for (int i = 0; i < ENQUEUERS + DEQUEUERS; i++){
+            pthread_create(&threads[i], NULL, i < ENQUEUERS ? enqueuer : dequeuer, &workers[i]);
+        }
+        for (int i = 0; i < ENQUEUERS + DEQUEUERS; i++){
+            pthread_join(threads[i], NULL);
+        }
+        size += ENQUEUERS * ITEMS_PER_ENQUEUER - round.dequeues;
+        if (round.failed || !checkQueue(round.q, size)){
+            printf("round %d: the queue is broken\n", r);
+            failed++;
+        }
+    }
+
+    void* item;
+    while ((item = IsraeliQueueDequeue(round.q)) != NULL){
+        dequeuedTimes[(int*)item - values]++;
+    }
+    for (int i = ENQUEUERS; i < ENQUEUERS + DEQUEUERS; i++){
+        for (int j = 0; j < workers[i].count; j++){
+            dequeuedTimes[workers[i].dequeued[j]]++;
+        }
+    }
+    int lost = 0, twice = 0;
+    for (int i = 0; i < ITEMS; i++){
+        if (dequeuedTimes[i] == 0)  lost++;
+        if (dequeuedTimes[i] > 1)   twice++;
+    }
+    if (lost > 0 || twice > 0){
+        printf("%d items lost, %d dequeued more than once\n", lost, twice);
+        failed++;
+    }
+
+    if (!checkDequeueLatency()){
+        printf("a dequeue waited for a scan, or the queue is broken\n");
+        failed++;
+    }
+
+    printf("%d rounds of %d enqueuers and %d dequeuers, %d items: %s\n", ROUNDS, ENQUEUERS, DEQUEUERS, ITEMS,
+           failed == 0 ? "passed" : "failed");
+    pthread_mutex_destroy(&(round.lock));
+    IsraeliQueueDestroy(round.q);
+    free(dequeued);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#undef NDEBUG // every build defines it, the asserts of IsraeliQueue.c and its storage walk need it undefined
+#include "IsraeliQueue.c" // the storage walk is internal
+#include "testFixtures.h"
+
+// walks the storage of queues after every kind of change: random enqueues, dequeues, clones, snapshots, merges
+// and improvements are applied to a few queues, of every storage engine, and after each one the walk of
+// countIsraeliNodes over the nodes, the arrays or the source of a snapshot must find exactly the size the
+// queue keeps, and the node pool statistics must match the slabs; the asserts of IsraeliQueue.c are enabled as well
+
+#define SEEDS 60
+#define OPS 400
+#define QUEUES 4    // the first queue, which keeps its options, and the clones, snapshots and merges made from the queues
+#define POOL_SLAB 16
+#define MAX_MERGED 300  // merges copying queues into each other would otherwise double them
+
+unsigned long hashInt(void* item){
+    return (unsigned long)*(int*)item;
+}
+
+// returns whether walking the storage of q finds exactly the size it keeps
+bool consistent(IsraeliQueue q){
+    int walked = countIsraeliNodes(q);
+    return walked >= 0 && walked == q->size && IsraeliQueueSize(q) == walked;
+}
+
+// returns whether the node pool statistics of q match its slabs and the nodes it holds, retired ones included
+bool poolConsistent(IsraeliQueue q){
+    IsraeliQueuePoolStats stats;
+    if (IsraeliQueueGetPoolStats(q, &stats) != ISRAELIQUEUE_SUCCESS)  return false;
+    int slabs = 0, held = q->source || isArrayStorage(q) ? 0 : q->size;
+    for (israeliSlab* slab = q->pool.slabs; slab != NULL; slab = slab->next){
+        slabs++;
+    }
+    for (israeliNode* node = q->retired; node != NULL; node = node->previous){
+        held++;
+    }
+    if (q->options.nodePoolSlabSize <= 0)  return stats.slabs == 0 && stats.capacity == 0 && stats.inUse == 0;
+    return stats.slabs == slabs && stats.capacity == slabs * q->options.nodePoolSlabSize && stats.inUse == held;
+}
+
+// returns a random queue other than except among the ones that exist, the first one if there is none
+int pickQueue(IsraeliQueue* queues, int except){
+    int i = (int)(nextRandom() % QUEUES);
+    return queues[i] && i != except ? i : (except == 0 ? -1 : 0);
+}
+
+// runs one random sequence of changes, returns the name of the first change after which a walk failed
+const char* runSeed(unsigned testSeed, const IsraeliQueueOptions* options, int* values){
+    seedRandom(testSeed);
+    fillTables(-20, 60);
+    FriendshipFunction functions[] = { table0, table1, NULL };
+    functions[testSeed % 3] = NULL;
+    IsraeliQueue queues[QUEUES] = { NULL };
+    queues[0] = IsraeliQueueCreateWithOptions(functions, compareInts, 20 + (int)(nextRandom() % 20),
+                                              (int)(nextRandom() % 10), options);
+    if (!queues[0])  return "create";
+
+    const char* failure = NULL;
+    const char* change;
+    IsraeliQueue merged;
+    for (int i = 0; i < OPS && !failure; i++){
+        values[i] = (int)(nextRandom() % FIXTURE_VALUES);
+        unsigned op = nextRandom() % 20;
+        int k = pickQueue(queues, -1);
+        int other = pickQueue(queues, k);
+        int slot = (int)(nextRandom() % (QUEUES - 1)) + 1; // a slot for a new queue, never the first one
+        if (op < 8){
+            change = "enqueue";
+            if (IsraeliQueueEnqueue(queues[k], &values[i]) != ISRAELIQUEUE_SUCCESS)  failure = change;
+        }
+        else if (op < 12){
+            change = "dequeue";
+            IsraeliQueueDequeue(queues[k]);
+        }
+        else if (op < 14){
+            change = "clone";
+            merged = IsraeliQueueClone(queues[k]);
+            IsraeliQueueDestroy(queues[slot]);
+            queues[slot] = merged;
+        }
+        else if (op < 16){
+            change = "snapshot";
+            merged = IsraeliQueueSnapshot(queues[k]);
+            IsraeliQueueDestroy(queues[slot]);
+            queues[slot] = merged;
+        }
+        else if (op < 17){
+            change = "improve positions";
+            if (IsraeliQueueImprovePositions(queues[k]) != ISRAELIQUEUE_SUCCESS)  failure = change;
+        }
+        else if (op < 19 && other >= 0 && queues[k]->size + queues[other]->size <= MAX_MERGED){
+            change = op == 17 ? "merge" : "merge copy";
+            IsraeliQueue inputs[] = { queues[k], queues[other], NULL };
+            merged = op == 17 ? IsraeliQueueMerge(inputs, compareInts) : IsraeliQueueMergeCopy(inputs, compareInts);
+            if (!merged)  failure = change;
+            IsraeliQueueDestroy(queues[slot]);
+            queues[slot] = merged;
+        }
+        else{
+            change = "destroy";
+            IsraeliQueueDestroy(queues[slot]);
+            queues[slot] = NULL;
+        }
+
+        for (int j = 0; j < QUEUES && !failure; j++){
+            if (queues[j] && (!consistent(queues[j]) || !poolConsistent(queues[j])))  failure = change;
+        }
+    }
+
+    for (int j = 1; j < QUEUES; j++){
+        IsraeliQueueDestroy(queues[j]);
+    }
+    // releasing the slabs of the pool takes back what they counted, and the pool grows again from nothing
+    IsraeliQueuePoolStats stats;
+    if (!failure && options->nodePoolSlabSize > 0){
+        freeElements(queues[0]);
+        IsraeliQueueGetPoolStats(queues[0], &stats);
+        if (stats.slabs != 0 || stats.capacity != 0 || stats.inUse != 0 || !consistent(queues[0]))  failure = "release of the pool";
+        IsraeliQueueEnqueue(queues[0], &values[0]);
+        IsraeliQueueGetPoolStats(queues[0], &stats);
+        if (stats.slabs != 1 || stats.inUse != 1 || !poolConsistent(queues[0]))  failure = "release of the pool";
+    }
+    IsraeliQueueDestroy(queues[0]);
+    return failure;
+}
+
+int main(){
+    IsraeliQueueOptions options[5] = { { 0 }, { 0 }, { 0 }, { 0 }, { 0 } };
+    options[1].storage = ISRAELIQUEUE_STORAGE_ARRAY;
+    options[2].nodePoolSlabSize = POOL_SLAB;
+    options[3].pairCacheSize = 64;
+    options[4].hashFunc = hashInt;
+    options[4].storage = ISRAELIQUEUE_STORAGE_ARRAY;
+    const char* names[5] = { "list", "array", "pool", "cache", "hashed array" };
+
+    int values[OPS];
+    int failed = 0;
+    const char* failure;
+    for (unsigned testSeed = 1; testSeed <= SEEDS; testSeed++){
+        for (int i = 0; i < 5; i++){
+            failure = runSeed(testSeed, &options[i], values);
+            if (failure){
+                printf("seed %u, %s storage: the storage is broken after a %s\n", testSeed, names[i], failure);
+                failed++;
+            }
+        }
+    }
+
+    printf("%d of %d runs passed\n", 5 * SEEDS - failed, 5 * SEEDS);
+    return failed == 0 ? 0 : 1;
+}
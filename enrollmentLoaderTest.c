@@ -0,0 +1,239 @@
+#define STUDENTS_PART_MIN_SIZE (1 << 12) // small students files are split as well
+#define LOADER_PROCESSORS 4              // and into several parts even on a single processor
+#include "HackEnrollment.c" // the split of the students file is internal
+
+// differential test of the loaders: random students, courses, hackers and queues files are written, and each
+// set is run through createEnrollment and readEnrollment with the files open, one worker, as the sequential
+// reference; then through the same with several workers, and through createEnrollmentFromPaths and
+// readEnrollmentFromPath, with one worker and with several; the output of hackEnrollment must be the same
+// bytes every time
+// the split of the students file is forced down to 4 KiB parts, so the mapped runs of all but the smallest
+// files read the students in parts; some files end their lines with "\r\n", or have no line end at the end
+
+#define SEEDS 120
+#define MAX_STUDENTS 3000   // the largest files span several chunks of the reader of an open file
+#define MAX_COURSES 40
+#define MAX_HACKERS 30
+#define MAX_COURSE_SIZE 30
+#define SEVERAL_WORKERS 3
+
+#define STUDENTS_PATH "enrollmentLoaderTest_students.txt"
+#define COURSES_PATH "enrollmentLoaderTest_courses.txt"
+#define HACKERS_PATH "enrollmentLoaderTest_hackers.txt"
+#define QUEUES_PATH "enrollmentLoaderTest_queues.txt"
+
+static unsigned seed = 1;
+
+unsigned nextRandom(){
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+void writeWord(FILE* file, int minLength, int maxLength){
+    int length = minLength + (int)(nextRandom() % (maxLength - minLength + 1));
+    fputc((nextRandom() % 2 ? 'A' : 'a') + (int)(nextRandom() % 26), file);
+    for (int i = 1; i < length; i++){
+        fputc('a' + (int)(nextRandom() % 26), file);
+    }
+}
+
+// ends a line, the last one of a file only if last is false or the file keeps its last line end
+void endLine(FILE* file, bool crlf, bool last, bool lastLineEnd){
+    if (last && !lastLineEnd)  return;
+    if (crlf)  fputc('\r', file);
+    fputc('\n', file);
+}
+
+// writes a line of count random IDs, distinct or not, out of the n given
+void writeIDs(FILE* file, const long* ids, int n, int count){
+    for (int j = 0; j < count; j++){
+        fprintf(file, "%s%ld", j == 0 ? "" : " ", ids[nextRandom() % n]);
+    }
+}
+
+// writes the four files of one seed, returns false if any of them couldn't be written
+bool writeFiles(unsigned testSeed, long* studentIDs, long* courseNums){
+    seed = testSeed;
+    bool crlf = testSeed % 4 == 0;
+    bool lastLineEnd = testSeed % 5 != 0;
+    int sizeClass = (int)(testSeed % 3); // a few students, some hundreds, or thousands
+    int students = sizeClass == 0 ? 3 + (int)(nextRandom() % 30)
+                 : sizeClass == 1 ? 30 + (int)(nextRandom() % 400) : MAX_STUDENTS / 2 + (int)(nextRandom() % (MAX_STUDENTS / 2));
+    int courses = 1 + (int)(nextRandom() % MAX_COURSES);
+    int hackers = (int)(nextRandom() % (MAX_HACKERS + 1));
+    if (hackers > students)  hackers = students;
+
+    FILE* studentsFile = fopen(STUDENTS_PATH, "wb");
+    FILE* coursesFile = fopen(COURSES_PATH, "wb");
+    FILE* hackersFile = fopen(HACKERS_PATH, "wb");
+    FILE* queuesFile = fopen(QUEUES_PATH, "wb");
+    bool opened = studentsFile && coursesFile && hackersFile && queuesFile;
+
+    // <Student ID> <Total Credits> <GPA> <Name> <Surname> <City> <Department>, the IDs distinct and out of order
+    long id = 100000000 + (long)(nextRandom() % 1000);
+    for (int i = 0; i < students; i++){
+        id += 1 + (long)(nextRandom() % 50);
+        studentIDs[i] = id;
+    }
+    long swap; int other;
+    for (int i = students - 1; i > 0; i--){
+        other = (int)(nextRandom() % (i + 1));
+        swap = studentIDs[i];
+        studentIDs[i] = studentIDs[other];
+        studentIDs[other] = swap;
+    }
+    for (int i = 0; opened && i < students; i++){
+        fprintf(studentsFile, "%ld %d %d ", studentIDs[i], (int)(nextRandom() % 200), 55 + (int)(nextRandom() % 46));
+        writeWord(studentsFile, 1, 12);
+        fputc(' ', studentsFile);
+        writeWord(studentsFile, 1, 12);
+        fprintf(studentsFile, " City%d Department%d", (int)(nextRandom() % 10), (int)(nextRandom() % 5));
+        endLine(studentsFile, crlf, i == students - 1, lastLineEnd);
+    }
+    // <Course Number> <Size>
+    for (int i = 0; opened && i < courses; i++){
+        courseNums[i] = 100000 + 10L * i + (long)(nextRandom() % 10);
+        fprintf(coursesFile, "%ld %d", courseNums[i], (int)(nextRandom() % (MAX_COURSE_SIZE + 1)));
+        endLine(coursesFile, crlf, i == courses - 1, lastLineEnd);
+    }
+    // <Student ID>, then the desired courses, the friends and the rivals, one line each, none of them empty
+    for (int i = 0; opened && i < hackers; i++){
+        fprintf(hackersFile, "%ld", studentIDs[i * (students / hackers)]);
+        endLine(hackersFile, crlf, false, true);
+        writeIDs(hackersFile, courseNums, courses, 1 + (int)(nextRandom() % 4));
+        endLine(hackersFile, crlf, false, true);
+        writeIDs(hackersFile, studentIDs, students, 1 + (int)(nextRandom() % 6));
+        endLine(hackersFile, crlf, false, true);
+        writeIDs(hackersFile, studentIDs, students, 1 + (int)(nextRandom() % 6));
+        endLine(hackersFile, crlf, i == hackers - 1, lastLineEnd);
+    }
+    // <Course Number> <Student ID>*, a line for most courses, out of order, and sometimes a second line for one
+    int lines = courses + (int)(nextRandom() % 3);
+    for (int i = 0; opened && i < lines; i++){
+        fprintf(queuesFile, "%ld ", courseNums[nextRandom() % courses]);
+        writeIDs(queuesFile, studentIDs, students, 1 + (int)(nextRandom() % MAX_COURSE_SIZE));
+        endLine(queuesFile, crlf, i == lines - 1, lastLineEnd);
+    }
+
+    bool written = opened;
+    if (studentsFile)  written = fclose(studentsFile) == 0 && written;
+    if (coursesFile)   written = fclose(coursesFile) == 0 && written;
+    if (hackersFile)   written = fclose(hackersFile) == 0 && written;
+    if (queuesFile)    written = fclose(queuesFile) == 0 && written;
+    return written;
+}
+
+// returns the number of parts the mapped students file is read in, 0 if it couldn't be mapped
+int studentsParts(){
+    MappedFile mapped;
+    if (mapFile(STUDENTS_PATH, &mapped) != HACKENROLLMENT_SUCCESS)  return 0;
+    Reader* reader = createMappedReader(&mapped);
+    StudentsPart parts[LOADER_MAX_THREADS];
+    int count = reader ? splitStudentsText(reader, parts) : 0;
+    destroyReader(reader);
+    unmapFile(&mapped);
+    return count;
+}
+
+// loads the files through open files or through their paths, with the given workers, and runs hackEnrollment
+// returns its output, malloc'd and '\0' terminated, or NULL if a step failed
+char* runOnce(bool mapped, int workers){
+    FILE* students = NULL; FILE* courses = NULL; FILE* hackers = NULL; FILE* queues = NULL;
+    if (!mapped){
+        students = fopen(STUDENTS_PATH, "rb");
+        courses = fopen(COURSES_PATH, "rb");
+        hackers = fopen(HACKERS_PATH, "rb");
+        queues = fopen(QUEUES_PATH, "rb");
+    }
+    FILE* out = tmpfile();
+    EnrollmentSystem sys = NULL;
+    if (out && (mapped || (students && courses && hackers && queues))){
+        sys = mapped ? createEnrollmentFromPaths(STUDENTS_PATH, COURSES_PATH, HACKERS_PATH)
+                     : createEnrollment(students, courses, hackers);
+    }
+    if (sys && setEnrollmentWorkers(sys, workers) != HACKENROLLMENT_SUCCESS){
+        destroyEnrollment(sys);
+        sys = NULL;
+    }
+    if (sys){
+        sys = mapped ? readEnrollmentFromPath(sys, QUEUES_PATH) : readEnrollment(sys, queues);
+    }
+
+    char* output = NULL;
+    if (sys && hackEnrollment(sys, out) == HACKENROLLMENT_SUCCESS){
+        long length = ftell(out);
+        output = length >= 0 ? (char*)malloc((size_t)length + 1) : NULL;
+        rewind(out);
+        if (output && fread(output, sizeof(char), (size_t)length, out) == (size_t)length){
+            output[length] = '\0';
+        }
+        else{
+            free(output);
+            output = NULL;
+        }
+    }
+
+    destroyEnrollment(sys);
+    if (students)  fclose(students);
+    if (courses)   fclose(courses);
+    if (hackers)   fclose(hackers);
+    if (queues)    fclose(queues);
+    if (out)       fclose(out);
+    return output;
+}
+
+int main(){
+    long* studentIDs = (long*)malloc(MAX_STUDENTS * sizeof(long));
+    long courseNums[MAX_COURSES];
+    if (!studentIDs){
+        printf("couldn't allocate the test\n");
+        return 2;
+    }
+
+    const bool mappedRuns[3] = { false, true, true };
+    const int workersRuns[3] = { SEVERAL_WORKERS, 1, SEVERAL_WORKERS };
+    int failed = 0, split = 0, unsatisfied = 0;
+    bool same;
+    char* reference; char* output;
+    for (unsigned testSeed = 1; testSeed <= SEEDS; testSeed++){
+        if (!writeFiles(testSeed, studentIDs, courseNums)){
+            printf("couldn't write the files\n");
+            failed++;
+            break;
+        }
+        if (studentsParts() > 1)  split++;
+        reference = runOnce(false, 1);
+        if (!reference){
+            printf("seed %u: the sequential run failed\n", testSeed);
+            failed++;
+            continue;
+        }
+        if (strncmp(reference, "Cannot satisfy", 14) == 0)  unsatisfied++;
+        same = true;
+        for (int i = 0; i < 3 && same; i++){
+            output = runOnce(mappedRuns[i], workersRuns[i]);
+            same = output && strcmp(output, reference) == 0;
+            if (!same){
+                printf("seed %u: %s with %d workers %s the sequential run\n", testSeed,
+                       mappedRuns[i] ? "the paths" : "the open files", workersRuns[i], output ? "differs from" : "failed, unlike");
+                failed++;
+            }
+            free(output);
+        }
+        free(reference);
+    }
+
+    // the split and the unsatisfied hackers must have been covered
+    printf("%d of %d seeds passed, %d with the students file read in parts, %d with an unsatisfied hacker\n",
+           SEEDS - failed, SEEDS, split, unsatisfied);
+    if (split == 0 || unsatisfied == 0 || unsatisfied == SEEDS){
+        printf("the files didn't cover the split students file or both outcomes of hackEnrollment\n");
+        failed++;
+    }
+    remove(STUDENTS_PATH);
+    remove(COURSES_PATH);
+    remove(HACKERS_PATH);
+    remove(QUEUES_PATH);
+    free(studentIDs);
+    return failed == 0 ? 0 : 1;
+}
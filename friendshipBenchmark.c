@@ -0,0 +1,119 @@
+#include "HackEnrollment.c" // the friendship functions and the Student struct are internal
+#include <time.h>
+
+// times the three built-in friendship functions over every pair of a set of made up students, the way the
+// enqueue scans of a course queue call them, next to summing both names on every call as it was done before
+// the sum was stored on Student
+
+#define STUDENTS 2000
+#define HACKER_EVERY 10 // one student out of HACKER_EVERY is a hacker
+#define HACKER_FRIENDS 20
+#define HACKER_RIVALS 20
+#define MAX_NAME 12
+
+static unsigned seed = 2023;
+
+unsigned nextRandom(){
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// the name measure as it was before the sums were precomputed
+int findNameAsciiDifferenceBySumming(void* student1, void* student2){
+    if (!student1 || !student2) return -1;
+    long value1 = findStringAscii(((Student*)student1)->name);
+    long value2 = findStringAscii(((Student*)student2)->name);
+
+    return ((int)(absL(value1 - value2)));
+}
+
+int compareLongs(const void* id1, const void* id2){
+    long difference = *(const long*)id1 - *(const long*)id2;
+    return (difference > 0) - (difference < 0);
+}
+
+// a sorted set of count IDs of random students, repeats removed
+bool fillIDSet(IDSet* set, Student* students, int count){
+    set->ids = (long*)malloc(count * sizeof(long));
+    if (!(set->ids))  return false;
+    for (int i = 0; i < count; i++){
+        set->ids[i] = students[nextRandom() % STUDENTS].studentID;
+    }
+    qsort(set->ids, count, sizeof(long), compareLongs);
+    set->size = 0;
+    for (int i = 0; i < count; i++){
+        if (set->size == 0 || set->ids[set->size - 1] != set->ids[i]){
+            set->ids[set->size++] = set->ids[i];
+        }
+    }
+    return true;
+}
+
+// returns the nanoseconds per call of the function over every ordered pair of students
+double measure(FriendshipFunction function, Student* students, long* checksum_ptr){
+    long checksum = 0;
+    clock_t start = clock();
+    for (int i = 0; i < STUDENTS; i++){
+        for (int j = 0; j < STUDENTS; j++){
+            checksum += function(&students[i], &students[j]);
+        }
+    }
+    clock_t end = clock();
+    *checksum_ptr = checksum; // keeps the calls from being optimized away
+    return (double)(end - start) / CLOCKS_PER_SEC * 1e9 / ((double)STUDENTS * STUDENTS);
+}
+
+int main(){
+    Student* students = (Student*)malloc(STUDENTS * sizeof(Student));
+    char* names = (char*)malloc(STUDENTS * MAX_NAME);
+    Hacker* hackers = (Hacker*)malloc((STUDENTS / HACKER_EVERY + 1) * sizeof(Hacker));
+    if (!students || !names || !hackers){
+        printf("couldn't allocate the students\n");
+        return 1;
+    }
+
+    int length;
+    for (int i = 0; i < STUDENTS; i++){
+        students[i].studentID = 100000000 + (long)(nextRandom() % 900000000);
+        length = 3 + (int)(nextRandom() % (MAX_NAME - 2));
+        for (int c = 0; c < length; c++){
+            names[i * MAX_NAME + c] = (char)('a' + nextRandom() % 26);
+        }
+        students[i].name.chars = names + i * MAX_NAME;
+        students[i].name.length = (size_t)length;
+        students[i].nameAscii = findStringAscii(students[i].name);
+        students[i].hackerAlt = NULL;
+    }
+    int hackersCount = 0;
+    for (int i = 0; i < STUDENTS; i += HACKER_EVERY){
+        Hacker* hacker = &hackers[hackersCount++];
+        hacker->desiredCourses = NULL;
+        hacker->desiredCount = 0;
+        if (!fillIDSet(&(hacker->friendsIDs), students, HACKER_FRIENDS) ||
+            !fillIDSet(&(hacker->rivalsIDs), students, HACKER_RIVALS)){
+            printf("couldn't allocate the hackers\n");
+            return 1;
+        }
+        students[i].hackerAlt = hacker;
+    }
+
+    FriendshipFunction functions[] = { areFriendsAccordingToHacker, findNameAsciiDifference, findIDDifference,
+                                       findNameAsciiDifferenceBySumming };
+    const char* labels[] = { "areFriendsAccordingToHacker", "findNameAsciiDifference", "findIDDifference",
+                             "findNameAsciiDifference, summing" };
+    long checksum;
+    printf("%d students, %d calls per function\n", STUDENTS, STUDENTS * STUDENTS);
+    for (int i = 0; i < 4; i++){
+        double nanoseconds = measure(functions[i], students, &checksum);
+        printf("%-34s %8.2f ns/call (checksum %ld)\n", labels[i], nanoseconds, checksum);
+    }
+
+    for (int i = 0; i < hackersCount; i++){
+        free(hackers[i].friendsIDs.ids);
+        free(hackers[i].rivalsIDs.ids);
+    }
+    free(hackers);
+    free(names);
+    free(students);
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "testFixtures.h"
+
+// randomized differential test of IsraeliQueueImprovePositions: random enqueues, dequeues and improvements
+// are applied both to queues of every storage engine and to a naive model of the original algorithm, which
+// rescans the whole queue for every element, and the orders must stay identical
+
+#define SEEDS 300
+#define MAX_OPS 600
+#define POOL_SLAB 16
+
+static int friendshipThreshold, rivalryThreshold;
+
+// THE MODEL
+typedef struct Model {
+    void* elements[MAX_OPS];
+    int friendsPassed[MAX_OPS];
+    int rivalsBlocked[MAX_OPS];
+    int size;
+} Model;
+
+void scorePairModel(void* element, void* item, bool* friends_ptr, bool* rivals_ptr){
+    int score0 = table0(element, item), score1 = table1(element, item);
+    *friends_ptr = score0 > friendshipThreshold || score1 > friendshipThreshold;
+    *rivals_ptr = !(*friends_ptr) && (score0 + score1) / 2 < rivalryThreshold;
+}
+
+// enqueues the item with the given counters, scanning the whole queue
+void enqueueModel(Model* m, void* item, int friendsPassed, int rivalsBlocked){
+    int last = m->size - 1;
+    int friend = last;
+    bool friends, rivals, lastIsFriend = false;
+    for (int i = 0; i < m->size; i++){
+        scorePairModel(m->elements[i], item, &friends, &rivals);
+        if (friend == last && friends && m->friendsPassed[i] < FRIEND_QUOTA){
+            friend = i;
+        }
+        if (rivals && m->rivalsBlocked[i] < RIVAL_QUOTA){
+            m->rivalsBlocked[i]++;
+            friend = last;
+        }
+        if (i == last){
+            lastIsFriend = friends;
+        }
+    }
+    if (m->size > 0 && (friend != last || lastIsFriend)){
+        m->friendsPassed[friend]++;
+    }
+
+    int at = friend + 1; // last + 1 when it can't skip
+    for (int i = m->size; i > at; i--){
+        m->elements[i] = m->elements[i - 1];
+        m->friendsPassed[i] = m->friendsPassed[i - 1];
+        m->rivalsBlocked[i] = m->rivalsBlocked[i - 1];
+    }
+    m->elements[at] = item;
+    m->friendsPassed[at] = friendsPassed;
+    m->rivalsBlocked[at] = rivalsBlocked;
+    m->size++;
+}
+
+void removeModel(Model* m, int at){
+    for (int i = at; i < m->size - 1; i++){
+        m->elements[i] = m->elements[i + 1];
+        m->friendsPassed[i] = m->friendsPassed[i + 1];
+        m->rivalsBlocked[i] = m->rivalsBlocked[i + 1];
+    }
+    m->size--;
+}
+
+// the original algorithm: from the back of the original order, every element is taken out and enqueued
+// again with its counters
+void improveModel(Model* m){
+    void* original[MAX_OPS];
+    int count = m->size;
+    for (int i = 0; i < count; i++){
+        original[i] = m->elements[i];
+    }
+    int at, friendsPassed, rivalsBlocked;
+    for (int k = count - 1; k >= 0; k--){
+        for (at = 0; m->elements[at] != original[k]; at++);
+        friendsPassed = m->friendsPassed[at];
+        rivalsBlocked = m->rivalsBlocked[at];
+        removeModel(m, at);
+        enqueueModel(m, original[k], friendsPassed, rivalsBlocked);
+    }
+}
+
+// returns whether q holds exactly the elements of the model, in the same order
+bool sameOrder(IsraeliQueue q, Model* m){
+    void* elements[MAX_OPS];
+    return holdsInOrder(q, m->elements, m->size, elements);
+}
+
+// runs one random sequence of operations, returns false on the first difference
+bool runSeed(unsigned testSeed, int* values){
+    seedRandom(testSeed);
+    fillTables(-20, 60);
+    friendshipThreshold = 20 + (int)(nextRandom() % 20);
+    rivalryThreshold = (int)(nextRandom() % 10);
+    // a queue without rivals takes no shortcut, so some seeds have none
+    if (testSeed % 4 == 0)  rivalryThreshold = -100;
+
+    FriendshipFunction functions[] = { table0, table1, NULL };
+    IsraeliQueueOptions options[3] = { { 0 }, { 0 }, { 0 } };
+    options[1].storage = ISRAELIQUEUE_STORAGE_ARRAY;
+    options[2].nodePoolSlabSize = POOL_SLAB;
+    IsraeliQueue queues[3];
+    for (int i = 0; i < 3; i++){
+        queues[i] = IsraeliQueueCreateWithOptions(functions, compareInts, friendshipThreshold, rivalryThreshold, &options[i]);
+        if (!queues[i])  return false;
+    }
+    Model m;
+    m.size = 0;
+
+    bool same = true;
+    int ops = 100 + (int)(nextRandom() % (MAX_OPS - 100));
+    unsigned op;
+    for (int i = 0; i < ops && same; i++){
+        op = nextRandom() % 20;
+        if (op < 2 && m.size > 0){
+            removeModel(&m, 0);
+            for (int j = 0; j < 3; j++){
+                IsraeliQueueDequeue(queues[j]);
+            }
+        }
+        else if (op < 3){
+            improveModel(&m);
+            for (int j = 0; j < 3; j++){
+                same = same && IsraeliQueueImprovePositions(queues[j]) == ISRAELIQUEUE_SUCCESS && sameOrder(queues[j], &m);
+            }
+        }
+        else{
+            enqueueModel(&m, &values[i], 0, 0);
+            for (int j = 0; j < 3; j++){
+                same = same && IsraeliQueueEnqueue(queues[j], &values[i]) == ISRAELIQUEUE_SUCCESS;
+            }
+        }
+    }
+    improveModel(&m); // always end with an improvement of the full queue
+    for (int j = 0; j < 3; j++){
+        same = same && IsraeliQueueImprovePositions(queues[j]) == ISRAELIQUEUE_SUCCESS && sameOrder(queues[j], &m);
+        IsraeliQueueDestroy(queues[j]);
+    }
+    return same;
+}
+
+int main(){
+    int values[MAX_OPS];
+    int failed = 0;
+    for (unsigned testSeed = 1; testSeed <= SEEDS; testSeed++){
+        seedRandom(testSeed * 7919u);
+        for (int i = 0; i < MAX_OPS; i++){
+            values[i] = (int)(nextRandom() % FIXTURE_VALUES);
+        }
+        if (!runSeed(testSeed, values)){
+            printf("seed %u: IsraeliQueueImprovePositions differs from the original algorithm\n", testSeed);
+            failed++;
+        }
+    }
+
+    printf("%d of %d seeds passed\n", SEEDS - failed, SEEDS);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+#include "testFixtures.h"
+#include <limits.h>
+#include <stdint.h>
+
+// checks the thresholds given to merged queues at the overflow boundaries: thresholds at INT_MIN and INT_MAX,
+// rivalry threshold products just below and above 2^64, and thousands of queues
+// the merged rivalry threshold is checked exactly against big integers: it must be the smallest r with
+// r^n >= the product of the n absolute thresholds, clamped to INT_MAX
+
+#define MAX_QUEUES 5000
+#define RANDOM_CASES 300
+
+// defined in IsraeliQueue.c
+int findMergedFriendshipThreshold(IsraeliQueue* qArr);
+int findMergedRivalryThreshold(IsraeliQueue* qArr);
+
+// BIG INTEGERS, little endian base 2^32 digits
+typedef struct BigInt {
+    uint32_t* digits;
+    int length;
+} BigInt;
+
+void bigSetOne(BigInt* big){
+    big->digits[0] = 1;
+    big->length = 1;
+}
+
+// factor is at most 2^32
+void bigMultiply(BigInt* big, uint64_t factor){
+    uint64_t carry = 0, product;
+    for (int i = 0; i < big->length; i++){
+        product = (uint64_t)big->digits[i] * factor + carry; // at most (2^32 - 1) * 2^32 + 2^32 - 1
+        big->digits[i] = (uint32_t)product;
+        carry = product >> 32;
+    }
+    while (carry > 0){
+        big->digits[big->length++] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    while (big->length > 1 && big->digits[big->length - 1] == 0){
+        big->length--;
+    }
+}
+
+int bigCompare(BigInt* big1, BigInt* big2){
+    if (big1->length != big2->length)  return big1->length < big2->length ? -1 : 1;
+    for (int i = big1->length - 1; i >= 0; i--){
+        if (big1->digits[i] != big2->digits[i])  return big1->digits[i] < big2->digits[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+uint64_t absThresholdOf(int threshold){
+    return threshold < 0 ? (uint64_t)(-(int64_t)threshold) : (uint64_t)threshold;
+}
+
+// whether root^n compares to the product as expected (at least it, or below it)
+bool powerComparesTo(BigInt* product, BigInt* power, uint64_t root, int n, bool atLeast){
+    bigSetOne(power);
+    for (int i = 0; i < n; i++){
+        bigMultiply(power, root);
+    }
+    int comparison = bigCompare(power, product);
+    return atLeast ? comparison >= 0 : comparison < 0;
+}
+
+// checks the merged rivalry threshold of queues with the n given rivalry thresholds
+bool checkRivalry(IsraeliQueue* queues, const int* thresholds, int n, BigInt* product, BigInt* power){
+    FriendshipFunction noFunctions[] = { NULL };
+    for (int i = 0; i < n; i++){
+        queues[i] = IsraeliQueueCreate(noFunctions, compareInts, 0, thresholds[i]);
+        if (!queues[i])  return false;
+    }
+    queues[n] = NULL;
+    int merged = findMergedRivalryThreshold(queues);
+    for (int i = 0; i < n; i++){
+        IsraeliQueueDestroy(queues[i]);
+    }
+    if (merged < 0)  return false;
+
+    bigSetOne(product);
+    for (int i = 0; i < n; i++){
+        bigMultiply(product, absThresholdOf(thresholds[i]));
+    }
+    if (product->length == 1 && product->digits[0] == 0)  return merged == 0;
+    if (merged == 0)  return false;
+    // merged is the root unless the root is above INT_MAX, which can only be when it is 2^31
+    uint64_t root = (uint64_t)merged;
+    if (merged == INT_MAX && powerComparesTo(product, power, root, n, false))  root++;
+    return powerComparesTo(product, power, root, n, true) && powerComparesTo(product, power, root - 1, n, false);
+}
+
+// checks the merged friendship threshold of queues with the n given friendship thresholds
+// a merged queue gets 0 whatever they are, as it always did
+bool checkFriendship(IsraeliQueue* queues, const int* thresholds, int n){
+    FriendshipFunction noFunctions[] = { NULL };
+    for (int i = 0; i < n; i++){
+        queues[i] = IsraeliQueueCreate(noFunctions, compareInts, thresholds[i], 0);
+        if (!queues[i])  return false;
+    }
+    queues[n] = NULL;
+    int merged = findMergedFriendshipThreshold(queues);
+    for (int i = 0; i < n; i++){
+        IsraeliQueueDestroy(queues[i]);
+    }
+    return merged == 0;
+}
+
+int main(){
+    IsraeliQueue* queues = (IsraeliQueue*)malloc((MAX_QUEUES + 1) * sizeof(IsraeliQueue));
+    int* thresholds = (int*)malloc(MAX_QUEUES * sizeof(int));
+    // a product of MAX_QUEUES thresholds, each below 2^32, and a power of a root below 2^32 have at most
+    // MAX_QUEUES digits, plus one for the carry
+    BigInt product = { (uint32_t*)malloc((MAX_QUEUES + 2) * sizeof(uint32_t)), 0 };
+    BigInt power = { (uint32_t*)malloc((MAX_QUEUES + 2) * sizeof(uint32_t)), 0 };
+    if (!queues || !thresholds || !(product.digits) || !(power.digits)){
+        printf("couldn't allocate the test\n");
+        return 2;
+    }
+
+    seedRandom(12345);
+    int passed = 0, failed = 0;
+    // {count, thresholds...}, products around 2^64 are either just below it or just above it
+    int cases[][6] = {
+        { 1, INT_MIN }, { 1, INT_MAX }, { 1, 0 }, { 1, 1 }, { 1, -1 },
+        { 2, INT_MIN, INT_MIN }, { 2, INT_MAX, INT_MAX }, { 2, INT_MIN, INT_MAX }, { 2, INT_MAX, 0 },
+        { 3, INT_MAX, INT_MAX, 4 },                   // 2^64 - 2^34 + 4, fits
+        { 3, INT_MIN, INT_MIN, 3 },                   // 3 * 2^62, fits
+        { 3, INT_MIN, INT_MIN, 4 },                   // exactly 2^64, the first product that doesn't fit
+        { 3, INT_MIN, INT_MIN, -5 },
+        { 3, INT_MIN, INT_MAX, INT_MIN },
+        { 4, 65535, 65535, 65535, 65535 },            // just below 2^64
+        { 4, 65536, 65536, 65536, 65536 },            // exactly 2^64, an integer root through the logarithms
+        { 4, 65536, 65536, 65536, 65537 },
+        { 4, -65536, 65535, 65536, -65536 },
+        { 5, 7131, 7131, 7131, 7131, 7131 },          // 7131^5 is just above 2^64
+        { 5, 7130, 7130, 7130, 7130, 7130 },          // 7130^5 is just below it
+        { 5, INT_MAX, INT_MIN, INT_MAX, INT_MIN, 1 },
+    };
+    int count = (int)(sizeof(cases) / sizeof(cases[0]));
+    for (int i = 0; i < count; i++){
+        if (checkRivalry(queues, cases[i] + 1, cases[i][0], &product, &power))  passed++;
+        else{
+            printf("rivalry case %d failed\n", i);
+            failed++;
+        }
+    }
+
+    // thousands of queues
+    int fills[] = { INT_MAX, INT_MIN, 7, -2 };
+    for (int k = 0; k < 4; k++){
+        for (int i = 0; i < MAX_QUEUES; i++){
+            thresholds[i] = fills[k];
+        }
+        thresholds[MAX_QUEUES - 1] = k == 3 ? 3 : fills[k]; // 2^4999 * 3, whose root is just above 2
+        if (checkRivalry(queues, thresholds, MAX_QUEUES, &product, &power))  passed++;
+        else{
+            printf("rivalry of %d queues with threshold %d failed\n", MAX_QUEUES, fills[k]);
+            failed++;
+        }
+    }
+
+    // random thresholds, small and large, some counts big enough to overflow 64 bits
+    int n;
+    for (int i = 0; i < RANDOM_CASES; i++){
+        n = 1 + (int)(nextRandom() % (i % 10 == 0 ? MAX_QUEUES : 40));
+        for (int j = 0; j < n; j++){
+            thresholds[j] = i % 2 == 0 ? (int)(nextRandom() % 2001) - 1000 : (int)((nextRandom() << 8) ^ nextRandom());
+            if (thresholds[j] == 0)  thresholds[j] = 1; // a single 0 makes the whole case trivial
+        }
+        if (checkRivalry(queues, thresholds, n, &product, &power))  passed++;
+        else{
+            printf("random rivalry case %d (%d queues) failed\n", i, n);
+            failed++;
+        }
+    }
+
+    // the friendship threshold, with sums of the thresholds that would overflow an int
+    for (int i = 0; i < MAX_QUEUES; i++){
+        thresholds[i] = i % 2 == 0 ? INT_MAX : INT_MIN;
+    }
+    struct { const int* thresholds; int n; } friendshipCases[] = {
+        { thresholds, 1 }, { thresholds + 1, 1 }, { thresholds, 2 }, { thresholds, 3 },
+        { thresholds, MAX_QUEUES }, { thresholds, MAX_QUEUES - 1 },
+    };
+    count = (int)(sizeof(friendshipCases) / sizeof(friendshipCases[0]));
+    for (int i = 0; i < count; i++){
+        if (checkFriendship(queues, friendshipCases[i].thresholds, friendshipCases[i].n))  passed++;
+        else{
+            printf("friendship case %d failed\n", i);
+            failed++;
+        }
+    }
+    for (int i = 0; i < MAX_QUEUES; i++){
+        thresholds[i] = INT_MAX;
+    }
+    if (checkFriendship(queues, thresholds, MAX_QUEUES))  passed++;
+    else{
+        printf("friendship of %d queues at INT_MAX failed\n", MAX_QUEUES);
+        failed++;
+    }
+
+    printf("%d of %d cases passed\n", passed, passed + failed);
+    free(power.digits);
+    free(product.digits);
+    free(thresholds);
+    free(queues);
+    return failed == 0 ? 0 : 1;
+}
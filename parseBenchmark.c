@@ -0,0 +1,171 @@
+#define _POSIX_C_SOURCE 199309L // clock_gettime, the loaders run on several threads so CPU time would mislead
+#include "HackEnrollment.h"
+#include <time.h>
+
+// measures how fast the input files are parsed, in MB/s: writes big students, courses, hackers and queues files,
+// then loads them through open files (the buffered reader) and through their paths (mapped in place)
+
+#define STUDENTS 400000
+#define COURSES 1000
+#define HACKERS 1000
+#define QUEUE_LENGTH 400 // students in the queue of every course
+#define ROUNDS 3 // the best round is reported
+
+#define STUDENTS_PATH "parseBenchmark_students.txt"
+#define COURSES_PATH "parseBenchmark_courses.txt"
+#define HACKERS_PATH "parseBenchmark_hackers.txt"
+#define QUEUES_PATH "parseBenchmark_queues.txt"
+
+static unsigned seed = 4242;
+
+unsigned nextRandom(){
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+long studentID(int i){
+    return 100000000 + 7L * i;
+}
+
+void writeWord(FILE* file, int minLength, int maxLength){
+    int length = minLength + (int)(nextRandom() % (maxLength - minLength + 1));
+    fputc('A' + (int)(nextRandom() % 26), file);
+    for (int i = 1; i < length; i++){
+        fputc('a' + (int)(nextRandom() % 26), file);
+    }
+}
+
+// writes the four files, returns false if any of them couldn't be written
+bool writeFiles(){
+    FILE* students = fopen(STUDENTS_PATH, "w");
+    FILE* courses = fopen(COURSES_PATH, "w");
+    FILE* hackers = fopen(HACKERS_PATH, "w");
+    FILE* queues = fopen(QUEUES_PATH, "w");
+    bool opened = students && courses && hackers && queues;
+
+    // <Student ID> <Total Credits> <GPA> <Name> <Surname> <City> <Department>
+    for (int i = 0; opened && i < STUDENTS; i++){
+        fprintf(students, "%ld %d %d ", studentID(i), (int)(nextRandom() % 200), 55 + (int)(nextRandom() % 46));
+        writeWord(students, 3, 10);
+        fputc(' ', students);
+        writeWord(students, 4, 12);
+        fprintf(students, " City%d Department%d\n", (int)(nextRandom() % 50), (int)(nextRandom() % 20));
+    }
+    // <Course Number> <Size>
+    for (int i = 0; opened && i < COURSES; i++){
+        fprintf(courses, "%d %d\n", 10000 + i, 20 + (int)(nextRandom() % 200));
+    }
+    // <Student ID>, then the desired courses, the friends and the rivals, one line each
+    for (int i = 0; opened && i < HACKERS; i++){
+        fprintf(hackers, "%ld\n", studentID((int)(nextRandom() % STUDENTS)));
+        for (int j = 0; j < 3; j++){
+            fprintf(hackers, "%d%c", 10000 + (int)(nextRandom() % COURSES), j < 2 ? ' ' : '\n');
+        }
+        for (int k = 0; k < 2; k++){ // friends, then rivals
+            for (int j = 0; j < 5; j++){
+                fprintf(hackers, "%ld%c", studentID((int)(nextRandom() % STUDENTS)), j < 4 ? ' ' : '\n');
+            }
+        }
+    }
+    // <Course Number> <Student ID>*, one line per course
+    for (int i = 0; opened && i < COURSES; i++){
+        fprintf(queues, "%d", 10000 + i);
+        for (int j = 0; j < QUEUE_LENGTH; j++){
+            fprintf(queues, " %ld", studentID((int)(nextRandom() % STUDENTS)));
+        }
+        fputc('\n', queues);
+    }
+
+    bool written = opened;
+    if (students)  written = fclose(students) == 0 && written;
+    if (courses)   written = fclose(courses) == 0 && written;
+    if (hackers)   written = fclose(hackers) == 0 && written;
+    if (queues)    written = fclose(queues) == 0 && written;
+    return written;
+}
+
+double fileMegabytes(const char* path){
+    FILE* file = fopen(path, "r");
+    if (!file)  return 0;
+    fseek(file, 0, SEEK_END);
+    double size = (double)ftell(file) / (1 << 20);
+    fclose(file);
+    return size;
+}
+
+double secondsSince(struct timespec* start){
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start->tv_sec) + (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// loads the system once, through open files or through paths, and adds the time of each step
+bool loadOnce(bool mapped, double* createSeconds_ptr, double* readSeconds_ptr){
+    FILE* students = NULL; FILE* courses = NULL; FILE* hackers = NULL; FILE* queues = NULL;
+    if (!mapped){
+        students = fopen(STUDENTS_PATH, "r");
+        courses = fopen(COURSES_PATH, "r");
+        hackers = fopen(HACKERS_PATH, "r");
+        queues = fopen(QUEUES_PATH, "r");
+    }
+    bool loaded = mapped || (students && courses && hackers && queues);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    EnrollmentSystem sys = NULL;
+    if (loaded){
+        sys = mapped ? createEnrollmentFromPaths(STUDENTS_PATH, COURSES_PATH, HACKERS_PATH)
+                     : createEnrollment(students, courses, hackers);
+    }
+    *createSeconds_ptr = secondsSince(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (sys){
+        sys = mapped ? readEnrollmentFromPath(sys, QUEUES_PATH) : readEnrollment(sys, queues);
+    }
+    *readSeconds_ptr = secondsSince(&start);
+
+    loaded = sys != NULL;
+    destroyEnrollment(sys);
+    if (students)  fclose(students);
+    if (courses)   fclose(courses);
+    if (hackers)   fclose(hackers);
+    if (queues)    fclose(queues);
+    return loaded;
+}
+
+int main(){
+    if (!writeFiles()){
+        printf("couldn't write the files\n");
+        return 1;
+    }
+    double inputMegabytes = fileMegabytes(STUDENTS_PATH) + fileMegabytes(COURSES_PATH) + fileMegabytes(HACKERS_PATH);
+    double queuesMegabytes = fileMegabytes(QUEUES_PATH);
+    printf("students, courses and hackers: %.1f MB, queues: %.1f MB\n", inputMegabytes, queuesMegabytes);
+
+    int result = 0;
+    double createSeconds, readSeconds, bestCreate, bestRead;
+    for (int mapped = 0; mapped < 2 && result == 0; mapped++){
+        bestCreate = -1;
+        bestRead = -1;
+        for (int i = 0; i < ROUNDS; i++){
+            if (!loadOnce(mapped, &createSeconds, &readSeconds)){
+                printf("loading failed\n");
+                result = 2;
+                break;
+            }
+            if (bestCreate < 0 || createSeconds < bestCreate)  bestCreate = createSeconds;
+            if (bestRead < 0 || readSeconds < bestRead)  bestRead = readSeconds;
+        }
+        if (result == 0){
+            printf("%-26s %8.1f MB/s\n", mapped ? "createEnrollmentFromPaths" : "createEnrollment", inputMegabytes / bestCreate);
+            printf("%-26s %8.1f MB/s\n", mapped ? "readEnrollmentFromPath" : "readEnrollment", queuesMegabytes / bestRead);
+        }
+    }
+
+    remove(STUDENTS_PATH);
+    remove(COURSES_PATH);
+    remove(HACKERS_PATH);
+    remove(QUEUES_PATH);
+    return result;
+}
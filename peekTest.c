@@ -0,0 +1,153 @@
+#include "testFixtures.h"
+
+// checks IsraeliQueuePeekN and IsraeliQueueIndexOf on every storage engine, on snapshots of them and on a
+// concurrent queue: n of 0, around the size and past it, limits of 0, inside and past the size and negative,
+// missing elements, equal but distinct elements, and the bad parameters; then, on random queues with
+// friendship functions, PeekN must give the order in which the elements are dequeued
+
+#define ELEMENTS 40
+#define STORAGES 5
+#define SEEDS 100
+#define RANDOM_ITEMS 300
+#define POOL_SLAB 8
+
+static int values[ELEMENTS];
+static int equalValues[ELEMENTS];   // equal to values, distinct pointers
+static int missingValue = -1;
+
+unsigned long hashInt(void* item){
+    return (unsigned long)*(int*)item;
+}
+
+// returns whether q, holding &values[first] to &values[ELEMENTS - 1] in order, reads as such
+bool checkReads(IsraeliQueue q, int first){
+    void* out[ELEMENTS + 2];
+    void* sentinel = &missingValue;
+    int size = ELEMENTS - first;
+    for (int i = 0; i < ELEMENTS + 2; i++){
+        out[i] = sentinel;
+    }
+
+    // PeekN: n of 0, a few, one short of the size, exactly the size and past it, nothing written past what is returned
+    if (IsraeliQueuePeekN(q, out, 0) != 0 || out[0] != sentinel)  return false;
+    int few = size < 3 ? size : 3;
+    if (IsraeliQueuePeekN(q, out, 3) != few || out[few] != sentinel)  return false;
+    if (size > 0 && (IsraeliQueuePeekN(q, out, size - 1) != size - 1 || out[size - 1] != sentinel))  return false;
+    if (IsraeliQueuePeekN(q, out, size) != size || out[size] != sentinel)  return false;
+    if (IsraeliQueuePeekN(q, out, ELEMENTS + 1) != size || out[size] != sentinel)  return false;
+    for (int i = 0; i < size; i++){
+        if (out[i] != &values[first + i])  return false;
+    }
+    if (IsraeliQueuePeekN(q, out, -1) != -1 || IsraeliQueuePeekN(q, NULL, 1) != -1)  return false;
+
+    // IndexOf: the foremost equal element, within the limit only
+    int position;
+    for (int i = first; i < ELEMENTS; i++){
+        position = i - first;
+        if (IsraeliQueueIndexOf(q, &values[i], -1) != position || IsraeliQueueIndexOf(q, &equalValues[i], -1) != position ||
+            IsraeliQueueIndexOf(q, &values[i], position + 1) != position || IsraeliQueueIndexOf(q, &values[i], size + 5) != position ||
+            IsraeliQueueIndexOf(q, &values[i], position) != -1 || IsraeliQueueIndexOf(q, &values[i], 0) != -1){
+            return false;
+        }
+    }
+    for (int i = 0; i < first; i++){ // dequeued
+        if (IsraeliQueueIndexOf(q, &values[i], -1) != -1)  return false;
+    }
+    return IsraeliQueueIndexOf(q, &missingValue, -1) == -1 && IsraeliQueueIndexOf(q, &missingValue, 0) == -1 &&
+           IsraeliQueueIndexOf(q, NULL, -1) == -1;
+}
+
+// fills q with the values in order, then checks it, a snapshot of it, and both after dequeues from either
+bool checkQueue(IsraeliQueue q){
+    void* out[1];
+    if (IsraeliQueuePeekN(q, out, 1) != 0 || IsraeliQueueIndexOf(q, &values[0], -1) != -1)  return false; // empty
+    for (int i = 0; i < ELEMENTS; i++){
+        if (IsraeliQueueEnqueue(q, &values[i]) != ISRAELIQUEUE_SUCCESS)  return false;
+    }
+    if (!checkReads(q, 0))  return false;
+
+    IsraeliQueue snapshot = IsraeliQueueSnapshot(q);
+    bool passed = snapshot && checkReads(snapshot, 0);
+    for (int i = 0; i < 5 && passed; i++){ // the source moves on, the snapshot doesn't
+        passed = IsraeliQueueDequeue(q) == &values[i] && checkReads(q, i + 1) && checkReads(snapshot, 0);
+    }
+    for (int i = 0; i < 10 && passed; i++){
+        passed = IsraeliQueueDequeue(snapshot) == &values[i] && checkReads(snapshot, i + 1) && checkReads(q, 5);
+    }
+    IsraeliQueueDestroy(snapshot);
+    return passed && checkReads(q, 5);
+}
+
+// builds a random queue with friendship functions, returns whether PeekN gives the order of its dequeues
+bool checkDequeueOrder(unsigned testSeed, const IsraeliQueueOptions* options, int* items){
+    seedRandom(testSeed);
+    fillTables(-20, 60);
+    FriendshipFunction functions[] = { table0, table1, NULL };
+    IsraeliQueue q = IsraeliQueueCreateWithOptions(functions, compareInts, 20 + (int)(nextRandom() % 20),
+                                                   (int)(nextRandom() % 10), options);
+    if (!q)  return false;
+    bool passed = true;
+    for (int i = 0; i < RANDOM_ITEMS && passed; i++){
+        items[i] = (int)(nextRandom() % FIXTURE_VALUES);
+        passed = IsraeliQueueEnqueue(q, &items[i]) == ISRAELIQUEUE_SUCCESS;
+        if (passed && nextRandom() % 5 == 0)  IsraeliQueueDequeue(q);
+    }
+
+    void* out[RANDOM_ITEMS];
+    int size = IsraeliQueuePeekN(q, out, RANDOM_ITEMS);
+    passed = passed && size == IsraeliQueueSize(q);
+    for (int i = 0; i < size && passed; i++){
+        passed = IsraeliQueueIndexOf(q, out[i], -1) == 0 && IsraeliQueueDequeue(q) == out[i];
+    }
+    IsraeliQueueDestroy(q);
+    return passed;
+}
+
+int main(){
+    for (int i = 0; i < ELEMENTS; i++){
+        values[i] = i;
+        equalValues[i] = i;
+    }
+    IsraeliQueueOptions options[STORAGES] = { { 0 }, { 0 }, { 0 }, { 0 }, { 0 } };
+    options[1].storage = ISRAELIQUEUE_STORAGE_ARRAY;
+    options[2].nodePoolSlabSize = POOL_SLAB;
+    options[3].hashFunc = hashInt;
+    options[4].storage = ISRAELIQUEUE_STORAGE_ARRAY;
+    options[4].hashFunc = hashInt;
+    const char* names[STORAGES] = { "list", "array", "pool", "hashed list", "hashed array" };
+
+    int failed = 0;
+    FriendshipFunction noFunctions[] = { NULL }; // the queue keeps the order of the enqueues
+    IsraeliQueue q;
+    for (int i = 0; i < STORAGES; i++){
+        q = IsraeliQueueCreateWithOptions(noFunctions, compareInts, 0, 0, &options[i]);
+        if (!q || !checkQueue(q)){
+            printf("%s storage: the reads are wrong\n", names[i]);
+            failed++;
+        }
+        IsraeliQueueDestroy(q);
+    }
+    q = IsraeliQueueCreateConcurrent(noFunctions, compareInts, 0, 0);
+    if (!q || !checkQueue(q)){
+        printf("concurrent queue: the reads are wrong\n");
+        failed++;
+    }
+    IsraeliQueueDestroy(q);
+    if (IsraeliQueuePeekN(NULL, (void**)&q, 1) != -1 || IsraeliQueueIndexOf(NULL, &values[0], -1) != -1){
+        printf("a NULL queue isn't rejected\n");
+        failed++;
+    }
+
+    int items[RANDOM_ITEMS];
+    for (unsigned testSeed = 1; testSeed <= SEEDS; testSeed++){
+        for (int i = 0; i < 3; i++){
+            if (!checkDequeueOrder(testSeed, &options[i], items)){
+                printf("seed %u, %s storage: PeekN differs from the order of the dequeues\n", testSeed, names[i]);
+                failed++;
+            }
+        }
+    }
+
+    printf("%s\n", failed == 0 ? "passed" : "failed");
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+#include "testFixtures.h"
+
+// randomized test of IsraeliQueueSnapshot: a source queue and snapshots of it, and snapshots of those, are
+// changed in random turns, every one paired with an independent copy that gets the same changes; after every
+// change each queue must hold exactly what its copy holds, in the same order
+// a copy never shares or copies anything: the copy of a new snapshot is a new queue that replays every change
+// the snapshotted queue went through since it was created
+// snapshots are also destroyed, and sources destroyed before their snapshots; meant to run under
+// -fsanitize=address as well, which catches a snapshot reading memory its source freed
+
+#define SEEDS 200
+#define OPS 500
+#define SLOTS 5         // queues alive at once, each with its copy
+#define BATCH 3
+#define MAX_ELEMENTS (OPS * BATCH)
+#define POOL_SLAB 16
+
+typedef enum { ENQUEUE, DEQUEUE, ENQUEUE_BATCH, IMPROVE, ADD_MEASURE, FRIENDSHIP_THRESHOLD, RIVALRY_THRESHOLD } ChangeKind;
+
+typedef struct Change {
+    ChangeKind kind;
+    int arg;            // the first item, an index into values, or the new threshold
+} Change;
+
+typedef struct Slot {
+    IsraeliQueue q;     // a source or a snapshot
+    IsraeliQueue copy;
+    Change history[OPS]; // every change since the first queue of the chain was created
+    int changes;
+} Slot;
+
+static Slot slots[SLOTS];
+
+int minusTable0(void* item1, void* item2){
+    return -table0(item1, item2);
+}
+
+// applies the change to q, *dequeued_ptr is set to the element a dequeue returned
+IsraeliQueueError applyChange(IsraeliQueue q, Change change, int* values, void** dequeued_ptr){
+    void* batch[BATCH];
+    *dequeued_ptr = NULL;
+    switch (change.kind){
+        case ENQUEUE:
+            return IsraeliQueueEnqueue(q, &values[change.arg]);
+        case DEQUEUE:
+            *dequeued_ptr = IsraeliQueueDequeue(q);
+            return ISRAELIQUEUE_SUCCESS;
+        case ENQUEUE_BATCH:
+            for (int i = 0; i < BATCH; i++){
+                batch[i] = &values[change.arg + i];
+            }
+            return IsraeliQueueEnqueueBatch(q, batch, BATCH);
+        case IMPROVE:
+            return IsraeliQueueImprovePositions(q);
+        case ADD_MEASURE:
+            return IsraeliQueueAddFriendshipMeasure(q, minusTable0);
+        case FRIENDSHIP_THRESHOLD:
+            return IsraeliQueueUpdateFriendshipThreshold(q, change.arg);
+        default:
+            return IsraeliQueueUpdateRivalryThreshold(q, change.arg);
+    }
+}
+
+// returns a random change, taking the items it enqueues from values
+Change randomChange(int* used){
+    Change change;
+    unsigned op = nextRandom() % 16;
+    change.arg = *used;
+    if (op < 6){
+        change.kind = ENQUEUE;
+        (*used)++;
+    }
+    else if (op < 10)  change.kind = DEQUEUE;
+    else if (op < 11){
+        change.kind = ENQUEUE_BATCH;
+        *used += BATCH;
+    }
+    else if (op < 13)  change.kind = IMPROVE;
+    else if (op < 14)  change.kind = ADD_MEASURE;
+    else if (op < 15){
+        change.kind = FRIENDSHIP_THRESHOLD;
+        change.arg = 10 + (int)(nextRandom() % 30);
+    }
+    else{
+        change.kind = RIVALRY_THRESHOLD;
+        change.arg = (int)(nextRandom() % 10);
+    }
+    return change;
+}
+
+// returns whether the queue of every slot holds what its copy holds, in the same order
+bool sameAsCopies(void** buffer1, void** buffer2){
+    int size;
+    for (int i = 0; i < SLOTS; i++){
+        if (!(slots[i].q))  continue;
+        size = IsraeliQueuePeekN(slots[i].copy, buffer2, MAX_ELEMENTS);
+        if (size < 0 || !holdsInOrder(slots[i].q, buffer2, size, buffer1))  return false;
+    }
+    return true;
+}
+
+void destroySlot(Slot* slot){
+    IsraeliQueueDestroy(slot->q);
+    IsraeliQueueDestroy(slot->copy);
+    slot->q = NULL;
+    slot->copy = NULL;
+}
+
+// runs one random sequence of changes, snapshots and destructions, returns false on the first difference
+bool runSeed(unsigned testSeed, const IsraeliQueueOptions* options, int* values, void** buffer1, void** buffer2){
+    seedRandom(testSeed);
+    fillTables(-20, 60);
+    for (int i = 0; i < MAX_ELEMENTS; i++){
+        values[i] = (int)(nextRandom() % FIXTURE_VALUES);
+    }
+    FriendshipFunction functions[] = { table0, table1, NULL };
+    functions[testSeed % 3] = NULL;
+    int friendshipThreshold = 20 + (int)(nextRandom() % 20);
+    int rivalryThreshold = (int)(nextRandom() % 10);
+
+    for (int i = 0; i < SLOTS; i++){
+        slots[i].q = NULL;
+        slots[i].copy = NULL;
+    }
+    bool same = true;
+    int used = 0;
+    void* dequeued1;
+    void* dequeued2;
+    Change change;
+    for (int i = 0; i < OPS && same; i++){
+        Slot* slot = &slots[nextRandom() % SLOTS];
+        Slot* from = &slots[nextRandom() % SLOTS];
+        unsigned op = nextRandom() % 10;
+        if (!(slot->q)){ // a new source, or a snapshot of another queue
+            slot->copy = IsraeliQueueCreateWithOptions(functions, compareInts, friendshipThreshold, rivalryThreshold, options);
+            slot->changes = 0;
+            if (from->q && op < 7){
+                slot->q = IsraeliQueueSnapshot(from->q);
+                for (int j = 0; j < from->changes; j++){
+                    slot->history[slot->changes++] = from->history[j];
+                    applyChange(slot->copy, from->history[j], values, &dequeued2);
+                }
+            }
+            else{
+                slot->q = IsraeliQueueCreateWithOptions(functions, compareInts, friendshipThreshold, rivalryThreshold, options);
+            }
+            same = slot->q && slot->copy;
+        }
+        else if (op < 1){
+            destroySlot(slot); // the snapshots of it, if any, keep what it had
+        }
+        else if (op < 2){ // reads, which must not change anything
+            same = IsraeliQueueContains(slot->q, &values[i]) == IsraeliQueueContains(slot->copy, &values[i]) &&
+                   IsraeliQueueIndexOf(slot->q, &values[i], -1) == IsraeliQueueIndexOf(slot->copy, &values[i], -1) &&
+                   IsraeliQueueSize(slot->q) == IsraeliQueueSize(slot->copy);
+        }
+        else{
+            change = randomChange(&used);
+            same = applyChange(slot->q, change, values, &dequeued1) == applyChange(slot->copy, change, values, &dequeued2) &&
+                   dequeued1 == dequeued2;
+            slot->history[slot->changes++] = change;
+        }
+        same = same && sameAsCopies(buffer1, buffer2);
+    }
+
+    for (int i = 0; i < SLOTS; i++){
+        destroySlot(&slots[i]);
+    }
+    return same;
+}
+
+int main(){
+    IsraeliQueueOptions options[4] = { { 0 }, { 0 }, { 0 }, { 0 } };
+    options[1].storage = ISRAELIQUEUE_STORAGE_ARRAY;
+    options[2].nodePoolSlabSize = POOL_SLAB;
+    options[3].pairCacheSize = 64;
+    const char* names[4] = { "list", "array", "pool", "cache" };
+
+    int* values = (int*)malloc(MAX_ELEMENTS * sizeof(int));
+    void** buffer1 = (void**)malloc(MAX_ELEMENTS * sizeof(void*));
+    void** buffer2 = (void**)malloc(MAX_ELEMENTS * sizeof(void*));
+    if (!values || !buffer1 || !buffer2){
+        printf("couldn't allocate the test\n");
+        return 2;
+    }
+    int failed = 0;
+    for (unsigned testSeed = 1; testSeed <= SEEDS; testSeed++){
+        for (int i = 0; i < 4; i++){
+            if (!runSeed(testSeed, &options[i], values, buffer1, buffer2)){
+                printf("seed %u, %s storage: a snapshot differs from its copy\n", testSeed, names[i]);
+                failed++;
+            }
+        }
+    }
+
+    printf("%d of %d runs passed\n", 4 * SEEDS - failed, 4 * SEEDS);
+    free(values);
+    free(buffer1);
+    free(buffer2);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#include "StagingRing.h"
+#include "testFixtures.h"
+#include <pthread.h>
+#include <sched.h>
+
+// producer/consumer test of StagingRing: several threads push their own numbered items into a small ring
+// while the owning thread takes them out, with StagingRingPop or StagingRingDrain, and every producer's
+// items must come out exactly once and in the order it pushed them; then draining a ring into a queue with
+// a friendship function must give the same queue as enqueueing the items one by one
+
+#define PRODUCERS 4
+#define ITEMS_PER_PRODUCER 5000
+#define ITEMS (PRODUCERS * ITEMS_PER_PRODUCER)
+#define RING_CAPACITY 64    // small enough for the producers to fill it
+#define ORDER_ITEMS 3000    // items of the sequential comparison
+
+static int values[ITEMS];   // producer p pushes values[p * ITEMS_PER_PRODUCER + i], whose value is its index
+
+typedef struct Producer {
+    StagingRing ring;
+    int id;
+} Producer;
+
+int friendship(void* item1, void* item2){
+    return (*(int*)item1 * 7 + *(int*)item2) % 30;
+}
+
+void* producer(void* arg){
+    Producer* p = (Producer*)arg;
+    int first = p->id * ITEMS_PER_PRODUCER;
+    for (int i = first; i < first + ITEMS_PER_PRODUCER; i++){
+        while (StagingRingPush(p->ring, &values[i]) == STAGING_RING_FULL){
+            sched_yield(); // the owner is behind, one processor is enough to run both
+        }
+    }
+    return NULL;
+}
+
+// checks that the item is the next one of its producer, counting it in next
+bool takeItem(void* item, int* next){
+    int value = *(int*)item;
+    int p = value / ITEMS_PER_PRODUCER;
+    if (value < 0 || value >= ITEMS || value != p * ITEMS_PER_PRODUCER + next[p])  return false;
+    next[p]++;
+    return true;
+}
+
+// takes every item out of a ring that producers push into, returns false on the first item out of order
+bool runProducers(StagingRing ring){
+    Producer producers[PRODUCERS];
+    pthread_t threads[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++){
+        producers[i].ring = ring;
+        producers[i].id = i;
+        pthread_create(&threads[i], NULL, producer, &producers[i]);
+    }
+
+    FriendshipFunction noFunctions[] = { NULL };
+    IsraeliQueue q = IsraeliQueueCreate(noFunctions, compareInts, 0, 0); // keeps the pushed order
+    int next[PRODUCERS] = { 0 };
+    bool ordered = q != NULL;
+    int taken = 0, drained, round = 0;
+    void* item;
+    while (taken < ITEMS && ordered){
+        if (round++ % 3 == 0){
+            item = StagingRingPop(ring);
+            if (item){
+                ordered = takeItem(item, next);
+                taken++;
+            }
+        }
+        else{
+            ordered = StagingRingDrain(ring, q, &drained) == STAGING_RING_SUCCESS;
+            taken += drained;
+            while (ordered && (item = IsraeliQueueDequeue(q)) != NULL){
+                ordered = takeItem(item, next);
+            }
+        }
+        sched_yield();
+    }
+
+    for (int i = 0; i < PRODUCERS; i++){
+        pthread_join(threads[i], NULL);
+    }
+    IsraeliQueueDestroy(q);
+    for (int i = 0; i < PRODUCERS && ordered; i++){
+        ordered = next[i] == ITEMS_PER_PRODUCER;
+    }
+    return ordered && StagingRingPop(ring) == NULL;
+}
+
+// pushes items into the ring, draining it into one queue whenever it is full, and enqueues them one by one
+// into another, with dequeues in between; returns whether both queues end the same
+bool sameAsEnqueueing(StagingRing ring){
+    FriendshipFunction functions[] = { friendship, NULL };
+    IsraeliQueue drainedQueue = IsraeliQueueCreate(functions, compareInts, 25, 3);
+    IsraeliQueue sequential = IsraeliQueueCreate(functions, compareInts, 25, 3);
+    bool same = drainedQueue && sequential;
+    int drained;
+    for (int i = 0; i < ORDER_ITEMS && same; i++){
+        if (StagingRingPush(ring, &values[i]) == STAGING_RING_FULL){
+            same = StagingRingDrain(ring, drainedQueue, &drained) == STAGING_RING_SUCCESS && drained > 0 &&
+                   StagingRingPush(ring, &values[i]) == STAGING_RING_SUCCESS;
+        }
+        same = same && IsraeliQueueEnqueue(sequential, &values[i]) == ISRAELIQUEUE_SUCCESS;
+        if (i % 97 == 0 && same){
+            same = StagingRingDrain(ring, drainedQueue, &drained) == STAGING_RING_SUCCESS &&
+                   IsraeliQueueDequeue(drainedQueue) == IsraeliQueueDequeue(sequential);
+        }
+    }
+    same = same && StagingRingDrain(ring, drainedQueue, &drained) == STAGING_RING_SUCCESS &&
+           IsraeliQueueSize(drainedQueue) == IsraeliQueueSize(sequential);
+    void* item;
+    while (same && (item = IsraeliQueueDequeue(drainedQueue)) != NULL){
+        same = item == IsraeliQueueDequeue(sequential);
+    }
+
+    IsraeliQueueDestroy(drainedQueue);
+    IsraeliQueueDestroy(sequential);
+    return same;
+}
+
+int main(){
+    for (int i = 0; i < ITEMS; i++){
+        values[i] = i;
+    }
+    StagingRing ring = StagingRingCreate(RING_CAPACITY);
+    if (!ring){
+        printf("couldn't create the ring\n");
+        return 2;
+    }
+
+    int failed = 0;
+    if (StagingRingCapacity(ring) != RING_CAPACITY || StagingRingPush(ring, NULL) != STAGING_RING_BAD_PARAM ||
+        StagingRingCreate(0) != NULL){
+        printf("bad parameters aren't rejected\n");
+        failed++;
+    }
+    if (!runProducers(ring)){
+        printf("the items of %d producers weren't taken exactly once and in order\n", PRODUCERS);
+        failed++;
+    }
+    if (!sameAsEnqueueing(ring)){
+        printf("draining differs from enqueueing the items one by one\n");
+        failed++;
+    }
+
+    printf("%d producers, %d items: %s\n", PRODUCERS, ITEMS, failed == 0 ? "passed" : "failed");
+    StagingRingDestroy(ring);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include "testFixtures.h"
+#include <time.h>
+
+// compares the list and array storage engines on the scan of IsraeliQueueEnqueue, for 1k to 1M elements
+// nobody is a friend or a rival of anybody, so every enqueue scans the whole queue and lands last
+
+#define SCANS_PER_SIZE 20000000 // elements scanned at every size, so every size takes about as long
+#define MAX_SIZE 1000000
+
+int neutral(void* item1, void* item2){
+    (void)item1; (void)item2;
+    return 0;
+}
+
+// returns the nanoseconds per scanned element, or -1 on failure
+double measure(IsraeliQueueStorage storage, void** items, int size){
+    FriendshipFunction noFunctions[] = { NULL };
+    IsraeliQueueOptions options = { 0 };
+    options.storage = storage;
+    IsraeliQueue q = IsraeliQueueCreateWithOptions(noFunctions, compareInts, 1, -1, &options);
+    if (!q)  return -1;
+    // without friendship functions every item simply goes last, so filling the queue doesn't scan it
+    if (IsraeliQueueEnqueueBatch(q, items, size) != ISRAELIQUEUE_SUCCESS ||
+        IsraeliQueueAddFriendshipMeasure(q, neutral) != ISRAELIQUEUE_SUCCESS){
+        IsraeliQueueDestroy(q);
+        return -1;
+    }
+
+    int rounds = SCANS_PER_SIZE / size;
+    clock_t start = clock();
+    for (int i = 0; i < rounds; i++){ // the size stays the same
+        IsraeliQueueEnqueue(q, IsraeliQueueDequeue(q));
+    }
+    clock_t end = clock();
+
+    IsraeliQueueDestroy(q);
+    return (double)(end - start) / CLOCKS_PER_SEC * 1e9 / ((double)rounds * size);
+}
+
+int main(){
+    int* values = (int*)malloc(MAX_SIZE * sizeof(int));
+    void** items = (void**)malloc(MAX_SIZE * sizeof(void*));
+    if (!values || !items){
+        printf("couldn't allocate the items\n");
+        return 1;
+    }
+    for (int i = 0; i < MAX_SIZE; i++){
+        values[i] = i;
+        items[i] = &values[i];
+    }
+
+    printf("%10s %14s %14s\n", "elements", "list ns/elem", "array ns/elem");
+    for (int size = 1000; size <= MAX_SIZE; size *= 10){
+        double list = measure(ISRAELIQUEUE_STORAGE_LIST, items, size);
+        double array = measure(ISRAELIQUEUE_STORAGE_ARRAY, items, size);
+        if (list < 0 || array < 0){
+            printf("benchmark failed at %d elements\n", size);
+            return 2;
+        }
+        printf("%10d %14.2f %14.2f\n", size, list, array);
+    }
+
+    free(items);
+    free(values);
+    return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef TEST_FIXTURES_H
+#define TEST_FIXTURES_H
+
+#include "IsraeliQueue.h"
+
+// the fixtures shared by the test drivers and benchmarks: a seeded random sequence, random friendship
+// tables over small int values, the int comparison, and checking a queue's order
+// every driver is a program of its own that includes this header once, so everything here is static
+
+#define FIXTURE_VALUES 64 // distinct values, the friendship tables are indexed by them
+#define FIXTURE_TABLES 2
+
+static unsigned fixtureSeed = 1;
+static int fixtureTables[FIXTURE_TABLES][FIXTURE_VALUES][FIXTURE_VALUES];
+
+static inline void seedRandom(unsigned seed){
+    fixtureSeed = seed;
+}
+
+static inline unsigned nextRandom(void){
+    fixtureSeed = fixtureSeed * 1103515245u + 12345u;
+    return fixtureSeed >> 8;
+}
+
+// fills every table with random scores from low to low + range - 1, drawn from the current seed
+static inline void fillTables(int low, int range){
+    for (int k = 0; k < FIXTURE_TABLES; k++){
+        for (int i = 0; i < FIXTURE_VALUES; i++){
+            for (int j = 0; j < FIXTURE_VALUES; j++){
+                fixtureTables[k][i][j] = low + (int)(nextRandom() % range);
+            }
+        }
+    }
+}
+
+// friendship functions over items pointing to ints from 0 to FIXTURE_VALUES - 1
+static inline int table0(void* item1, void* item2){
+    return fixtureTables[0][*(int*)item1][*(int*)item2];
+}
+
+static inline int table1(void* item1, void* item2){
+    return fixtureTables[1][*(int*)item1][*(int*)item2];
+}
+
+static inline int compareInts(void* item1, void* item2){
+    return *(int*)item1 - *(int*)item2;
+}
+
+// returns whether q holds exactly the n expected elements, in the same order
+// buffer must have room for n elements
+static inline bool holdsInOrder(IsraeliQueue q, void** expected, int n, void** buffer){
+    if (IsraeliQueueSize(q) != n || IsraeliQueuePeekN(q, buffer, n) != n)  return false;
+    for (int i = 0; i < n; i++){
+        if (buffer[i] != expected[i])  return false;
+    }
+    return true;
+}
+
+#endif